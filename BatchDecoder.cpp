@@ -0,0 +1,296 @@
+#include "BatchDecoder.h"
+
+/*! \brief Create a worker
+*
+*	Create a worker of a batch, it's started by BatchDecoder::run()
+*
+*	@param batch batch the worker decodes for
+*/
+BatchWorker::BatchWorker(BatchDecoder *batch) : _batch(batch)
+{}
+
+/*! \brief Worker loop
+*
+*	Decode segments of the batch until there are none left
+*/
+void BatchWorker::run()
+{
+	_batch->work();
+}
+
+
+/*! \brief Create the batch
+*
+*	Create the batch decoder, decoders are opened with open()
+*
+*	@param workers number of worker threads, 0 = one per core
+*	@param maxPending max number of frames decoded and not consumed yet
+*/
+BatchDecoder::BatchDecoder(const int workers, const int maxPending) :
+	_decoders(workers > 0 ? workers : qMax(1, QThread::idealThreadCount())),
+	_maxPending(qMax(1, maxPending))
+{
+	for (int i = 0; i < _decoders.size(); ++i)
+		_workers.push_back(new BatchWorker(this));
+	_nextSegment = 0;
+	_head = 0;
+	_pending = 0;
+	_failed = false;
+	_abort = false;
+}
+
+/*! \brief Destroyer
+*
+*	Stop the workers and wait for them
+*/
+BatchDecoder::~BatchDecoder()
+{
+	_mutex.lock();
+	_abort = true;
+	_spaceCond.wakeAll();
+	_mutex.unlock();
+
+	for (BatchWorker *w : _workers) {
+		w->wait();
+		delete w;
+	}
+}
+
+
+/**************************************
+*********    VIDEO ACTIONS    *********
+***************************************/
+
+/*! \brief open a video.
+*
+*   Open the video with the decoders of all the workers and split it in
+*	segments. The workers already use all the cores, so by default each
+*	codec decodes on a single thread.
+*	@param fileName path to the video
+*	@param threading how each codec spreads the decoding over threads
+*	@param threads number of threads of each codec, 0 = one per core
+*	@return success or not
+*/
+bool BatchDecoder::open(
+	const QString fileName,
+	const QVideoDecoder::ThreadingMode threading,
+	const int threads
+)
+{
+	_segments.clear();
+	if (!_decoders.open(fileName, threading, threads))
+		return false;
+
+	// without the packets index the GOPs are unknown, starts stays empty
+	std::vector<qint64> starts;
+	QVideoDecoder *info = _decoders.getInfo();
+	info->getGopStarts(starts);
+	split(starts, info->getNumFrames());
+	return true;
+}
+
+/*! \brief decode the whole video
+*
+*	Decode all the frames of the video on the workers and give them to the
+*	consumer in frame order. Returns when the last frame has been consumed or
+*	the consumer stops the batch.
+*	@param consume called on the calling thread for each frame, returns
+*		false to stop the batch
+*	@param process called on the workers for each frame with the decoder
+*		on it, stores its result in BatchFrame::data; when null the frame is
+*		converted to RGB in BatchFrame::img
+*	@return success or not, false when a segment could not be decoded
+*/
+bool BatchDecoder::run(ConsumeFn consume, ProcessFn process)
+{
+	if (!_decoders.isOk() || _segments.empty())
+		return false;
+
+	_process = process;
+	_mutex.lock();
+	_ready.assign(_segments.size(), QQueue<BatchFrame>());
+	_done.assign(_segments.size(), false);
+	_nextSegment = 0;
+	_head = 0;
+	_pending = 0;
+	_failed = false;
+	_abort = false;
+	_mutex.unlock();
+
+	for (BatchWorker *w : _workers)
+		w->start();
+
+	// consume the segments in order, the workers fill the following ones
+	_mutex.lock();
+	while (_head < (int) _segments.size() && !_failed) {
+		if (!_ready[_head].isEmpty()) {
+			BatchFrame f = _ready[_head].dequeue();
+			--_pending;
+			_spaceCond.wakeAll();
+			_mutex.unlock();
+
+			bool more = consume(f);
+
+			_mutex.lock();
+			if (!more)
+				break;
+		}
+		else if (_done[_head]) {
+			++_head;
+			_spaceCond.wakeAll();
+		}
+		else {
+			_frameCond.wait(&_mutex);
+		}
+	}
+	bool ok = !_failed;
+	_abort = true;
+	_spaceCond.wakeAll();
+	_mutex.unlock();
+
+	for (BatchWorker *w : _workers)
+		w->wait();
+
+	_ready.clear();
+	_process = 0;
+	return ok;
+}
+
+
+/**************************************
+*********        GETTERS      *********
+***************************************/
+
+/*! \brief Get number of workers
+*
+*	Retrieve the number of worker threads
+*/
+int BatchDecoder::getWorkers()
+{
+	return _workers.size();
+}
+
+/*! \brief Get number of segments
+*
+*	Retrieve the number of segments the video has been split in
+*/
+int BatchDecoder::getNumSegments()
+{
+	return _segments.size();
+}
+
+/*! \brief Get the video properties
+*
+*	Get a decoder to read the properties of the video, it must not be used
+*	to decode
+*/
+QVideoDecoder *BatchDecoder::getInfo()
+{
+	return _decoders.getInfo();
+}
+
+
+/**************************************
+************    HELPERS    ************
+***************************************/
+
+/*! \brief decode segments
+*
+*	Take the next segment not decoded yet and decode it, until there are
+*	none left or the batch is stopped. Runs on the workers.
+*/
+void BatchDecoder::work()
+{
+	forever {
+		_mutex.lock();
+		if (_abort || _nextSegment >= (int) _segments.size()) {
+			_mutex.unlock();
+			return;
+		}
+		int s = _nextSegment++;
+		Segment seg = _segments[s];
+		_mutex.unlock();
+
+		QVideoDecoder *decoder = _decoders.acquire(seg.start);
+		bool ok = decoder && decoder->seekFrame(seg.start);
+		bool aborted = false, complete = false;
+		qint64 last = -1;		// last frame queued
+		while (ok) {
+			// numbered by the decoder, so a frame it drops or merges doesn't
+			// shift the next ones, and the segment stops at the next GOP
+			qint64 num = decoder->getActualFrameNumber();
+			if (seg.end != -1 && num >= seg.end) {
+				complete = true;
+				break;
+			}
+			if (num < seg.start) {
+				ok = decoder->readNextFrame();
+				continue;
+			}
+
+			BatchFrame f;
+			f.num = num;
+			f.time = decoder->getFrameTime();
+			if (_process)
+				_process(*decoder, f);
+			else
+				ok = decoder->getFrame(f.img, 0, &f.time);
+
+			// the segment being consumed only waits for its own frames, the
+			// consumer always drains it, the others for all the pending ones
+			_mutex.lock();
+			while (!_abort && (s == _head ? _ready[s].size() : _pending) >= _maxPending)
+				_spaceCond.wait(&_mutex);
+			if (_abort) {
+				aborted = true;
+				ok = false;
+			}
+			else if (ok) {
+				_ready[s].enqueue(f);
+				++_pending;
+				last = num;
+				_frameCond.wakeAll();
+			}
+			_mutex.unlock();
+
+			if (ok)
+				ok = decoder->readNextFrame();
+		}
+		if (decoder)
+			_decoders.release(decoder);
+
+		// a segment stopped before the next GOP is an error, the end of the
+		// video is found by the last one
+		_mutex.lock();
+		_done[s] = true;
+		if (!aborted && ((seg.end != -1 && !complete) || last == -1))
+			_failed = true;
+		_frameCond.wakeAll();
+		_mutex.unlock();
+	}
+}
+
+/*! \brief split the video in segments
+*
+*	Split the video in segments of whole GOPs, a few for each worker so they
+*	keep busy until the end even if the GOPs differ in length.
+*	@param starts first frame of every GOP, empty when unknown
+*	@param numFrames number of frames of the video
+*/
+void BatchDecoder::split(const std::vector<qint64> &starts, const qint64 numFrames)
+{
+	_segments.clear();
+
+	qint64 length = numFrames / (_workers.size() * BATCH_SEGMENTS_PER_WORKER);
+	Segment seg;
+	seg.start = 0;
+	for (size_t i = 1; i < starts.size(); ++i) {
+		if (starts[i] - seg.start >= length) {
+			seg.end = starts[i];
+			_segments.push_back(seg);
+			seg.start = starts[i];
+		}
+	}
+	seg.end = -1;
+	_segments.push_back(seg);
+}
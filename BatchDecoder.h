@@ -0,0 +1,113 @@
+#ifndef BATCHDECODER_H
+#define BATCHDECODER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QVariant>
+#include <vector>
+#include <functional>
+
+#include "QVideoDecoder.h"
+#include "DecoderPool.h"
+
+#define BATCH_MAX_PENDING			64	// frames decoded ahead of the consumer
+#define BATCH_SEGMENTS_PER_WORKER	4	// segments of each worker, balances the load
+
+//! Frame decoded by a batch
+struct BatchFrame {
+	QImage img;			//!< RGB frame, when no process function is given
+	QVariant data;		//!< result of the process function
+	qint64 num = -1;	//!< absolute frame number
+	qint64 time = -1;	//!< frame timestamp
+};
+
+class BatchDecoder;
+
+//! Thread decoding the segments of a batch
+class BatchWorker : public QThread
+{
+	BatchDecoder	*_batch;
+
+protected:
+	void run();
+
+public:
+	BatchWorker(BatchDecoder *batch);
+};
+
+/*!
+*	@brief Class used to decode a whole video on all the cores
+*
+*	Class used to decode a whole video on all the cores, for the operations
+*	that read every frame (shot detection, thumbnails export...).
+*	The video is split at the keyframes of the packets index in segments of
+*	a few GOPs, which are independent: every worker thread takes the next
+*	segment, seeks to its first frame with its own decoder of a DecoderPool
+*	and decodes it sequentially.
+*	An optional process function runs on the workers with the decoder on the
+*	frame, so the per-frame analysis is parallel too. Frames are given to the
+*	consumer on the calling thread in frame order; a worker ahead of the
+*	segment being consumed waits when too many frames are pending, and the
+*	worker of that segment when too many of its own frames are, so the
+*	memory used doesn't depend on the length of the video.
+*	Without the packets index the video is decoded as a single segment.
+*/
+class BatchDecoder
+{
+	friend class BatchWorker;
+
+public:
+	typedef std::function<void(QVideoDecoder &, BatchFrame &)>	ProcessFn;
+	typedef std::function<bool(BatchFrame &)>					ConsumeFn;
+
+private:
+	//! Frames between two GOP starts
+	struct Segment {
+		qint64 start;	//!< first frame
+		qint64 end;		//!< frame after the last one, -1 = end of the video
+	};
+
+	DecoderPool		_decoders;		//!< one decoder per worker
+	std::vector<BatchWorker *> _workers;
+	ProcessFn		_process;		//!< run on the workers, can be null
+
+	QMutex			_mutex;			//!< protects all the variables below
+	QWaitCondition	_frameCond;		//!< a frame is ready or a segment is done
+	QWaitCondition	_spaceCond;		//!< a frame has been consumed
+
+	std::vector<Segment>	_segments;
+	std::vector<QQueue<BatchFrame> > _ready;	//!< decoded frames of each segment
+	std::vector<bool>		_done;		//!< segments decoded
+	int				_nextSegment;	//!< first segment not taken by a worker
+	int				_head;			//!< segment being consumed
+	int				_pending;		//!< frames decoded and not consumed
+	int				_maxPending;	//!< max pending frames
+	bool			_failed;		//!< a segment could not be decoded
+	bool			_abort;			//!< stop the workers
+
+	//  Helpers
+	void	work();
+	void	split(const std::vector<qint64> &starts, const qint64 numFrames);
+
+public:
+
+	BatchDecoder(const int workers = 0, const int maxPending = BATCH_MAX_PENDING);
+	~BatchDecoder();
+
+	//  Video actions
+	bool	open(
+		const QString fileName,
+		const QVideoDecoder::ThreadingMode threading = QVideoDecoder::ThreadingNone,
+		const int threads = 0
+	);
+	bool	run(ConsumeFn consume, ProcessFn process = 0);
+
+	//  Getters
+	int		getWorkers();
+	int		getNumSegments();
+	QVideoDecoder *getInfo();
+};
+
+#endif // BATCHDECODER_H
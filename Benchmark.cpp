@@ -0,0 +1,263 @@
+#include <QElapsedTimer>
+#include <algorithm>
+
+#include "Benchmark.h"
+#include "ImagesBuffer.h"
+
+/*! \brief Create the benchmark
+*
+*	Create a benchmark with the default number of operations
+*/
+Benchmark::Benchmark()
+{
+	_seeks = BENCH_SEEKS;
+	_steps = BENCH_STEPS;
+	_strips = BENCH_STRIPS;
+	_stripSize = BENCH_STRIP_SIZE;
+	_frameCache = false;
+}
+
+/*! \brief Destroyer
+*
+*	Destroyer
+*/
+Benchmark::~Benchmark()
+{}
+
+
+/**************************************
+*********       SETTINGS      *********
+***************************************/
+
+/*! \brief set the number of random seeks
+*
+*	Set the number of random seeks of the decoder, of random jumps and of
+*	windows of the buffer
+*	@param seeks number of seeks
+*/
+void Benchmark::setSeeks(const int seeks)
+{
+	_seeks = qMax(seeks, 1);
+}
+
+/*! \brief set the number of steps
+*
+*	Set the number of frames stepped forward in the buffer
+*	@param steps number of frames
+*/
+void Benchmark::setSteps(const int steps)
+{
+	_steps = qMax(steps, 1);
+}
+
+/*! \brief set the preview strips
+*
+*	Set the number of preview strips filled and their size
+*	@param strips number of strips
+*	@param size thumbnails of a strip
+*/
+void Benchmark::setStrips(const int strips, const int size)
+{
+	_strips = qMax(strips, 1);
+	_stripSize = qMax(size, 1);
+}
+
+/*! \brief keep the frames cache
+*
+*	Measure the buffer with its frames cache, as the application uses it,
+*	or without it
+*	@param enable keep it or not
+*/
+void Benchmark::setFrameCache(const bool enable)
+{
+	_frameCache = enable;
+}
+
+
+/**************************************
+*******    BENCHMARK ACTIONS    *******
+***************************************/
+
+/*! \brief benchmark a video
+*
+*	Measure all the operations on a video, the decoder ones first: opening it
+*	builds the packets index that the buffer then finds.
+*	@param fileName path of the video
+*	@param r where the results will be stored
+*	@return success or not, the results measured before a failure are kept
+*/
+bool Benchmark::run(const QString &fileName, BenchmarkResult &r)
+{
+	r = BenchmarkResult();
+	r.video = fileName;
+	_random.seed(BENCH_SEED);
+
+	r.ok = benchDecoder(fileName, r) && benchBuffer(fileName, r);
+	return r.ok;
+}
+
+
+/**************************************
+************    HELPERS    ************
+***************************************/
+
+/*! \brief benchmark the decoder
+*
+*	Measure the opening, the sequential decoding of the whole video and
+*	random seeks of a QVideoDecoder, each seek followed by the RGB conversion
+*	of the frame
+*	@param fileName path of the video
+*	@param r where the results will be stored
+*	@return success or not
+*/
+bool Benchmark::benchDecoder(const QString &fileName, BenchmarkResult &r)
+{
+	QVideoDecoder decoder;
+	QElapsedTimer timer;
+
+	timer.start();
+	bool ok = decoder.openFile(fileName) && decoder.isOk();
+	r.openMs = timer.nsecsElapsed() / 1e6;
+	if (!ok)
+		return false;
+	r.numFrames = decoder.getNumFrames();
+
+	QImage img;
+	qint64 decoded = 0;
+	timer.restart();
+	ok = decoder.seekFrame(0);
+	while (ok && decoder.getFrame(img)) {
+		++decoded;
+		ok = decoder.readNextFrame();
+	}
+	double secs = timer.nsecsElapsed() / 1e9;
+	r.decodeFps = secs > 0 ? decoded / secs : 0;
+	if (decoded == 0)
+		return false;
+
+	std::vector<double> ms;
+	for (qint64 num : randomFrames(r.numFrames, _seeks)) {
+		timer.restart();
+		if (!decoder.seekFrame(num) || !decoder.getFrame(img))
+			return false;
+		ms.push_back(timer.nsecsElapsed() / 1e6);
+	}
+	r.seek = summarize(ms);
+
+	decoder.close();
+	return true;
+}
+
+/*! \brief benchmark the buffer
+*
+*	Measure an ImagesBuffer opened as the application does (without the
+*	filmstrip, which only runs in background): stepping forward one frame at
+*	a time, jumping to random frames, getting the frames around random ones
+*	and filling preview strips around random frames
+*	@param fileName path of the video
+*	@param r where the results will be stored
+*	@return success or not
+*/
+bool Benchmark::benchBuffer(const QString &fileName, BenchmarkResult &r)
+{
+	ImagesBuffer buffer(BENCH_BUFFER_SIZE);
+	buffer.setFilmstripEnabled(false);
+	buffer.setThumbnailSize(QSize(BENCH_THUMB_W, BENCH_THUMB_H));
+	if (!_frameCache)
+		buffer.setCacheBudget(0);
+
+	if (!buffer.loadVideo(fileName))
+		return false;
+	qint64 numFrames = buffer.getNumFrames();
+
+	QElapsedTimer timer;
+	std::vector<double> ms;
+	Frame f;
+
+	// one frame forward, the buffer slides when its end is reached
+	for (qint64 num = 1; num <= _steps && num < numFrames; ++num) {
+		timer.start();
+		if (!buffer.getFrame(f, num))
+			return false;
+		ms.push_back(timer.nsecsElapsed() / 1e6);
+	}
+	r.step = summarize(ms);
+
+	ms.clear();
+	for (qint64 num : randomFrames(numFrames, _seeks)) {
+		timer.start();
+		if (!buffer.getFrame(f, num))
+			return false;
+		ms.push_back(timer.nsecsElapsed() / 1e6);
+	}
+	r.jump = summarize(ms);
+
+	ms.clear();
+	std::vector<Frame> v;
+	for (qint64 mid : randomFrames(numFrames, _seeks)) {
+		v.clear();
+		timer.start();
+		buffer.getImagesBuffer(v, (int) mid, _stripSize);
+		ms.push_back(timer.nsecsElapsed() / 1e6);
+	}
+	r.window = summarize(ms);
+
+	ms.clear();
+	for (qint64 mid : randomFrames(numFrames, _strips)) {
+		v.clear();
+		timer.start();
+		buffer.getThumbnails(v, mid, _stripSize);
+		ms.push_back(timer.nsecsElapsed() / 1e6);
+	}
+	r.strip = summarize(ms);
+	return true;
+}
+
+/*! \brief random frames
+*
+*	Frame numbers spread uniformly over the video, from the generator seeded
+*	at the beginning of the run
+*	@param numFrames number of frames of the video
+*	@param count number of frames to give
+*/
+std::vector<qint64> Benchmark::randomFrames(const qint64 numFrames, const int count)
+{
+	std::vector<qint64> nums;
+	if (numFrames <= 0)
+		return nums;
+
+	std::uniform_int_distribution<qint64> dist(0, numFrames - 1);
+	for (int i = 0; i < count; ++i)
+		nums.push_back(dist(_random));
+	return nums;
+}
+
+/*! \brief summarize times
+*
+*	Mean, percentiles (nearest rank) and max of a list of times
+*	@param ms times in ms, sorted by the call
+*/
+BenchmarkTimes Benchmark::summarize(std::vector<double> &ms)
+{
+	BenchmarkTimes t;
+	if (ms.empty())
+		return t;
+
+	std::sort(ms.begin(), ms.end());
+	double sum = 0;
+	for (double v : ms)
+		sum += v;
+
+	auto rank = [&ms](const double p) {
+		size_t i = (size_t) (p * ms.size());
+		return ms[qMin(i, ms.size() - 1)];
+	};
+
+	t.count = ms.size();
+	t.mean = sum / ms.size();
+	t.p50 = rank(0.50);
+	t.p90 = rank(0.90);
+	t.p99 = rank(0.99);
+	t.max = ms.back();
+	return t;
+}
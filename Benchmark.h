@@ -0,0 +1,84 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QString>
+#include <vector>
+#include <random>
+
+#define BENCH_SEEKS			200		// random seeks of the decoder and of the buffer
+#define BENCH_STEPS			300		// frames stepped forward in the buffer
+#define BENCH_STRIPS		50		// preview strips filled
+#define BENCH_STRIP_SIZE	9		// thumbnails of a preview strip
+#define BENCH_BUFFER_SIZE	30		// frames of the ImagesBuffer, as in the application
+#define BENCH_THUMB_W		160		// width of the thumbnails
+#define BENCH_THUMB_H		90		// height of the thumbnails
+#define BENCH_SEED			12345	// random positions are the same at every run
+
+//! Distribution of the times of an operation, in ms
+struct BenchmarkTimes {
+	int		count = 0;
+	double	mean = 0;
+	double	p50 = 0;
+	double	p90 = 0;
+	double	p99 = 0;
+	double	max = 0;
+};
+
+//! Results of the benchmark of a video
+struct BenchmarkResult {
+	QString	video;
+	qint64	numFrames = 0;
+	double	openMs = 0;			//!< open the video, building its packets index if missing
+	double	decodeFps = 0;		//!< sequential decoding, converted to RGB
+	BenchmarkTimes	seek;		//!< QVideoDecoder::seekFrame and getFrame at random frames
+	BenchmarkTimes	step;		//!< ImagesBuffer::getFrame of the next frame, sliding the buffer
+	BenchmarkTimes	jump;		//!< ImagesBuffer::getFrame at random frames, refilling the buffer
+	BenchmarkTimes	window;		//!< ImagesBuffer::getImagesBuffer around random frames
+	BenchmarkTimes	strip;		//!< ImagesBuffer::getThumbnails around random frames
+	bool	ok = false;
+};
+
+/*!
+*	@brief Class used to measure the cost of decoder and buffer operations
+*
+*	Class used to measure the cost of the operations the user interface
+*	waits for, on a single video: sequential decoding, random seeks of a
+*	QVideoDecoder, stepping and jumping in the ImagesBuffer and filling a
+*	preview strip. Random positions come from a fixed seed, so two runs on
+*	the same video (e.g. two builds) do the same work and can be compared.
+*	Times are wall clock times, the first operations pay for opening the
+*	decoders as the application does. The frames cache of the ImagesBuffer
+*	is disabled unless asked, so the buffer times measure the decoding and
+*	don't depend on what the previous operations left in the cache.
+*/
+class Benchmark
+{
+	int		_seeks;
+	int		_steps;
+	int		_strips;
+	int		_stripSize;
+	bool	_frameCache;		//!< keep the frames cache of the ImagesBuffer
+	std::mt19937 _random;		//!< random frames, seeded at each run
+
+	//  Helpers
+	bool	benchDecoder(const QString &fileName, BenchmarkResult &r);
+	bool	benchBuffer(const QString &fileName, BenchmarkResult &r);
+	std::vector<qint64> randomFrames(const qint64 numFrames, const int count);
+	static BenchmarkTimes summarize(std::vector<double> &ms);
+
+public:
+
+	Benchmark();
+	~Benchmark();
+
+	//  Settings
+	void	setSeeks(const int seeks);
+	void	setSteps(const int steps);
+	void	setStrips(const int strips, const int size = BENCH_STRIP_SIZE);
+	void	setFrameCache(const bool enable);
+
+	//  Benchmark actions
+	bool	run(const QString &fileName, BenchmarkResult &r);
+};
+
+#endif // BENCHMARK_H
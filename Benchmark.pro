@@ -0,0 +1,47 @@
+# -------------------------------------------------
+# Benchmark of the decoder and of the buffer
+# -------------------------------------------------
+QT       += core gui widgets
+CONFIG   += c++11 console
+CONFIG   -= app_bundle
+
+TARGET = Benchmark
+TEMPLATE = app
+
+SOURCES +=  BenchmarkMain.cpp \
+            Benchmark.cpp \
+            SyntheticVideo.cpp \
+            ImagesBuffer.cpp \
+            DecoderPool.cpp \
+            FramePrefetcher.cpp \
+            FrameSeeker.cpp \
+            Filmstrip.cpp \
+            ThumbnailStore.cpp \
+            IndexScanner.cpp \
+            FrameCache.cpp \
+            QVideoDecoder.cpp \
+            FrameIndex.cpp \
+            Timeline.cpp \
+            ContainerStrategy.cpp \
+            FramePool.cpp
+
+HEADERS +=  Benchmark.h \
+            SyntheticVideo.h \
+            ImagesBuffer.h \
+            DecoderPool.h \
+            FramePrefetcher.h \
+            FrameSeeker.h \
+            Filmstrip.h \
+            ThumbnailStore.h \
+            IndexScanner.h \
+            FrameCache.h \
+            Frame.h \
+            QVideoDecoder.h \
+            FrameIndex.h \
+            Timeline.h \
+            ContainerStrategy.h \
+            FramePool.h \
+            ffmpeg.h
+
+include(ffmpeg.pri)
+include(profiler.pri)
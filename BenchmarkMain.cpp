@@ -0,0 +1,193 @@
+/*
+   ShotManager (2015 x64)
+		Luca Gallinari
+		Dario Stabili
+		Marco Ravazzini
+
+	Benchmark of the decoder and of the buffer: generates a test video for
+	each supported container (or takes the given ones) and measures the
+	operations the user interface waits for.
+
+*/
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <cstdio>
+
+#include "Benchmark.h"
+#include "SyntheticVideo.h"
+#include "ThumbnailStore.h"
+#include "FrameIndex.h"
+
+static bool verbose = false;
+
+/*! \brief Message handler
+*
+*	Drop the decoder debug messages unless verbose output is requested,
+*	printing them would be measured too
+*/
+static void messageHandler(QtMsgType type, const QMessageLogContext &, const QString &msg)
+{
+	if (type == QtDebugMsg && !verbose)
+		return;
+	fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+}
+
+/*! \brief Print the times of an operation
+*
+*	Print a line with the distribution of the times of an operation
+*/
+static void printTimes(const char *name, const BenchmarkTimes &t)
+{
+	printf("  %-16s mean %8.2f  p50 %8.2f  p90 %8.2f  p99 %8.2f  max %8.2f ms  (%d)\n",
+		name, t.mean, t.p50, t.p90, t.p99, t.max, t.count);
+}
+
+/*! \brief Print the results of a video
+*
+*	Print the results of a video, the ones not measured are skipped
+*/
+static void printResult(const BenchmarkResult &r)
+{
+	printf("%s%s\n", r.video.toLocal8Bit().constData(), r.ok ? "" : "  FAILED");
+	printf("  %-16s %8lld\n", "frames", (long long) r.numFrames);
+	printf("  %-16s %8.2f ms\n", "open", r.openMs);
+	printf("  %-16s %8.1f fps\n", "decode", r.decodeFps);
+	if (r.seek.count)
+		printTimes("decoder seek", r.seek);
+	if (r.step.count)
+		printTimes("buffer step", r.step);
+	if (r.jump.count)
+		printTimes("buffer jump", r.jump);
+	if (r.window.count)
+		printTimes("buffer window", r.window);
+	if (r.strip.count)
+		printTimes("preview strip", r.strip);
+	fflush(stdout);
+}
+
+/*! \brief Write the results as csv
+*
+*	Write one row per video, to compare the runs of different builds
+*/
+static bool writeCsv(const QString &fileName, const std::vector<BenchmarkResult> &results)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+		return false;
+
+	QTextStream out(&file);
+	out << "video,ok,frames,open_ms,decode_fps";
+	const char *ops[] = { "seek", "step", "jump", "window", "strip" };
+	for (const char *op : ops)
+		out << "," << op << "_mean," << op << "_p50," << op << "_p90," << op << "_p99," << op << "_max";
+	out << "\n";
+
+	for (const BenchmarkResult &r : results) {
+		out << r.video << "," << (r.ok ? 1 : 0) << "," << r.numFrames << "," << r.openMs << "," << r.decodeFps;
+		for (const BenchmarkTimes *t : { &r.seek, &r.step, &r.jump, &r.window, &r.strip })
+			out << "," << t->mean << "," << t->p50 << "," << t->p90 << "," << t->p99 << "," << t->max;
+		out << "\n";
+	}
+	return out.status() == QTextStream::Ok;
+}
+
+int main(int argc, char *argv[])
+{
+	// the buffer shows its errors in message boxes
+	QApplication a(argc, argv);
+	QCoreApplication::setApplicationName("ScenesManagerBenchmark");
+	qInstallMessageHandler(messageHandler);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Measure the decoder and the buffer on generated or given videos.");
+	parser.addHelpOption();
+	parser.addPositionalArgument("videos", "Videos to measure, test videos are generated when none is given.", "[videos...]");
+	QCommandLineOption dirOpt("dir", "Folder of the generated videos (default: temp folder).", "dir");
+	QCommandLineOption containersOpt("containers", "Containers to generate, comma separated (default: all).", "list", SyntheticVideo::containers().join(","));
+	QCommandLineOption framesOpt("frames", "Frames of the generated videos (default 750).", "num", "750");
+	QCommandLineOption widthOpt("width", "Width of the generated videos (default 1280).", "pixels", "1280");
+	QCommandLineOption heightOpt("height", "Height of the generated videos (default 720).", "pixels", "720");
+	QCommandLineOption seeksOpt("seeks", "Random seeks, jumps and windows (default 200).", "num", QString::number(BENCH_SEEKS));
+	QCommandLineOption stepsOpt("steps", "Frames stepped forward in the buffer (default 300).", "num", QString::number(BENCH_STEPS));
+	QCommandLineOption stripsOpt("strips", "Preview strips filled (default 50).", "num", QString::number(BENCH_STRIPS));
+	QCommandLineOption cacheOpt("cache", "Keep the frames cache of the buffer.");
+	QCommandLineOption keepOpt("keep", "Keep the generated videos and their index files.");
+	QCommandLineOption csvOpt("csv", "Also write the results to a csv file.", "file");
+	QCommandLineOption verboseOpt(QStringList() << "v" << "verbose", "Print the decoder messages.");
+	parser.addOption(dirOpt);
+	parser.addOption(containersOpt);
+	parser.addOption(framesOpt);
+	parser.addOption(widthOpt);
+	parser.addOption(heightOpt);
+	parser.addOption(seeksOpt);
+	parser.addOption(stepsOpt);
+	parser.addOption(stripsOpt);
+	parser.addOption(cacheOpt);
+	parser.addOption(keepOpt);
+	parser.addOption(csvOpt);
+	parser.addOption(verboseOpt);
+	parser.process(a);
+
+	verbose = parser.isSet(verboseOpt);
+
+	// the previews must be decoded, not found in the thumbnails of a previous run
+	QFile::remove(ThumbnailStore::defaultPath());
+
+	QStringList videos = parser.positionalArguments();
+	QStringList generated;
+	if (videos.isEmpty()) {
+		QDir dir(parser.isSet(dirOpt) ? parser.value(dirOpt) : QDir::temp().filePath("ScenesManagerBenchmark"));
+		if (!dir.mkpath(".")) {
+			fprintf(stderr, "Cannot create %s\n", dir.path().toLocal8Bit().constData());
+			return 2;
+		}
+
+		SyntheticVideo synth(parser.value(widthOpt).toInt(), parser.value(heightOpt).toInt());
+		for (const QString &c : parser.value(containersOpt).split(",", QString::SkipEmptyParts)) {
+			QString video = dir.filePath("bench." + c.trimmed());
+			fprintf(stderr, "Generating %s\n", video.toLocal8Bit().constData());
+			if (!synth.write(video, c.trimmed(), parser.value(framesOpt).toLongLong())) {
+				fprintf(stderr, "Cannot generate %s\n", video.toLocal8Bit().constData());
+				continue;
+			}
+			// a stale index of a previous run would skip the indexing
+			QFile::remove(FrameIndex::sidecarPath(video));
+			videos << video;
+			generated << video;
+		}
+	}
+	if (videos.isEmpty())
+		return 3;
+
+	Benchmark bench;
+	bench.setSeeks(parser.value(seeksOpt).toInt());
+	bench.setSteps(parser.value(stepsOpt).toInt());
+	bench.setStrips(parser.value(stripsOpt).toInt());
+	bench.setFrameCache(parser.isSet(cacheOpt));
+
+	std::vector<BenchmarkResult> results;
+	bool ok = true;
+	for (const QString &video : videos) {
+		BenchmarkResult r;
+		ok = bench.run(video, r) && ok;
+		printResult(r);
+		results.push_back(r);
+	}
+
+	if (parser.isSet(csvOpt) && !writeCsv(parser.value(csvOpt), results)) {
+		fprintf(stderr, "Cannot write %s\n", parser.value(csvOpt).toLocal8Bit().constData());
+		ok = false;
+	}
+
+	if (!parser.isSet(keepOpt)) {
+		for (const QString &video : generated) {
+			QFile::remove(video);
+			QFile::remove(FrameIndex::sidecarPath(video));
+		}
+	}
+	return ok ? 0 : 4;
+}
@@ -232,13 +232,9 @@ void CompareMarkersDialog::compare_differentF(QTextCursor c1, QTextCursor c2){
 					c1_Twrite(c1, i_max / 2);
 					c2_Twrite(c2, i_min / 2);
 				}
-				qDebug() << "i_min vale:" << i_min;
-				qDebug() << "i_max vale:" << i_max;
 			}
 			//otherwise, if markers are not equals...
 			else {
-				qDebug() << "i_min vale:" << i_min;
-				qDebug() << "i_max vale:" << i_max;
 
 				//if start markers are equals...
 				if (l_min[i_min] == l_max[i_max]){
@@ -251,8 +247,6 @@ void CompareMarkersDialog::compare_differentF(QTextCursor c1, QTextCursor c2){
 					//if the end marker of lower file is bigger than the other one...
 					if (l_min[i_min + 1] > l_max[i_max + 1]){
 
-						qDebug() << "fine_min > fine_max";
-
 						//if the end marker of lower file is bigger than the next start marker of the max file...
 						if (l_min[i_min + 1] > l_max[i_max + 2]){
 
@@ -265,8 +259,6 @@ void CompareMarkersDialog::compare_differentF(QTextCursor c1, QTextCursor c2){
 							//while this difference is more of 0, we are reading markers including in the max file markers
 							while (in_diff < end_diff){
 
-								qDebug() << "ricerca i compresi in max ";
-
 								//add space for including markers
 								addCursorBlock(c1, c2, blength, i_max);
 
@@ -285,8 +277,6 @@ void CompareMarkersDialog::compare_differentF(QTextCursor c1, QTextCursor c2){
 					//if the end marker of lower file is less than the other end marker...
 					else{
 
-						qDebug() << "fine_max > fine_min";
-
 						//if the end marker of lower file is more than the next end marker...
 						if (l_max[i_max + 1] > l_min[i_min + 2]){
 
@@ -296,7 +286,6 @@ void CompareMarkersDialog::compare_differentF(QTextCursor c1, QTextCursor c2){
 							int end_diff = std::abs(l_max[i_max + 2] - l_min[i_min + 1]);
 
 							while (in_diff < end_diff){
-								qDebug() << "ricerca i compresi in min ";
 
 								addCursorBlock(c1, c2, !blength, i_min);
 
@@ -315,12 +304,9 @@ void CompareMarkersDialog::compare_differentF(QTextCursor c1, QTextCursor c2){
 				//else if start markers are differents...
 				else if (l_min[i_min] != l_max[i_max]){ // se inizio diverso
 
-					qDebug() << "inizio diverso";
-
 					//if markers of lower file are including in markers of max file...
 					if (l_min[i_min] >= l_max[i_max] && l_min[i_min + 1] <= l_max[i_max + 1])
 					{
-						qDebug() << "qui - 2" << l_min[i_min] << l_max[i_max];
 						setBckCol();
 						if (blength){
 							c1_Bwrite(c1, i_min / 2);
@@ -335,7 +321,6 @@ void CompareMarkersDialog::compare_differentF(QTextCursor c1, QTextCursor c2){
 					else{
 						//if one of the markers of lower file is including in markers of max file...
 						if (l_min[i_min] >= l_max[i_max + 1] || l_min[i_min + 1] <= l_max[i_max]) {
-							qDebug() << "qui - 1";
 							if (l_min[i_min] >= l_max[i_max + 1]){
 								setBckCol();
 								addCursorBlock(c1, c2, blength, i_max);
@@ -352,7 +337,6 @@ void CompareMarkersDialog::compare_differentF(QTextCursor c1, QTextCursor c2){
 
 						//if both of the markers of lower file are not including in markers of max file...
 						else{
-							qDebug() << "qui - 3";
 							int in_diff = l_max[i_max + 1] - l_min[i_min];
 							int end_diff = 0;
 							if (i_max + 2 <l_max.length())  end_diff = l_min[i_min + 1] - l_max[i_max + 2];
@@ -367,15 +351,12 @@ void CompareMarkersDialog::compare_differentF(QTextCursor c1, QTextCursor c2){
 								c2_Bwrite(c2, i_min / 2);
 							}
 
-							qDebug() << "in_diff= " << in_diff << " e end_diff= " << end_diff;
-
 							if (in_diff < end_diff){
 
 								i_max += 2;
 								end_diff = l_min[i_min + 1] - l_max[i_max];
 
 								while (in_diff < end_diff){
-									qDebug() << "ricerca i compresi ";
 
 									addCursorBlock(c1, c2, blength, i_max);
 
@@ -394,15 +375,10 @@ void CompareMarkersDialog::compare_differentF(QTextCursor c1, QTextCursor c2){
 
 			}
 
-			qDebug() << "i_min a fine ciclo:" << i_min << "rispetto al Length: " << l_min.length();
-			qDebug() << "i_max a fine ciclo:" << i_max << "rispetto al Length: " << l_max.length();;
-
-
 		}
 
 		//When markers in the lower file are ended, write all reaming markers in max file
 		else{
-			qDebug() << "i_min finito, svuoto i_max";
 			while (i_max < l_max.length()) {
 
 				if (l_max[i_max] > l_min[i_min - 1]) setBckCol();
@@ -0,0 +1,323 @@
+#include <cmath>
+
+#include "ContainerStrategy.h"
+
+static const ffmpeg::AVRational millisecondbase = { 1, 1000 };
+
+/*! \brief Destroyer
+*
+*	Destroyer
+*/
+ContainerStrategy::~ContainerStrategy()
+{}
+
+/*! \brief Create the strategy of a format
+*
+*	Create the strategy that handles the timestamps of a format
+*	@param formatName name of the format, as given by ffmpeg
+*	@return the strategy, owned by the caller
+*/
+ContainerStrategy *ContainerStrategy::create(const QString &formatName)
+{
+	if (formatName == "mpeg")
+		return new MpegStrategy();
+	if (formatName == "asf")
+		return new AsfStrategy();
+	if (formatName.indexOf("mp4") != -1)
+		return new Mp4Strategy();
+	if (formatName == "matroska,webm")
+		return new MatroskaStrategy();
+	return new AviStrategy();
+}
+
+/*! \brief Set the timestamps infos
+*
+*	Set the timestamps infos of the video stream, must be called before any
+*	other method
+*	@param timing timestamps infos
+*/
+void ContainerStrategy::setTiming(const StreamTiming &timing)
+{
+	_timing = timing;
+}
+
+
+/**************************************
+********    CONTAINER PROPERTIES    ****
+***************************************/
+
+/*! \brief Timing from the first packet
+*
+*	The frame duration and the first dts must be read from the first decoded
+*	packet, the stream infos are not reliable
+*/
+bool ContainerStrategy::hasFirstPacketTiming() const
+{
+	return false;
+}
+
+/*! \brief Exact byte seeks
+*
+*	Seeking to the byte position of a keyframe lands exactly on it
+*/
+bool ContainerStrategy::canSeekByByte() const
+{
+	return false;
+}
+
+
+/**************************************
+*********    TIMESTAMPS    ************
+***************************************/
+
+/*! \brief Seek to a keyframe before a frame
+*
+*	Seek to a keyframe placed before the desired frame, based on a prediction
+*	of its position
+*	@param formatCtx format of the video
+*	@param codecCtx codec of the video stream
+*	@param stream index of the video stream
+*	@param idealFrameNumber number of the desired frame
+*	@return success or not
+*/
+bool ContainerStrategy::seekToKeyFrame(
+	ffmpeg::AVFormatContext *formatCtx,
+	ffmpeg::AVCodecContext *,
+	const int stream,
+	const qint64 idealFrameNumber
+) const
+{
+	qint64 startDts = INT64_MIN, desiredDts;
+	int flags;
+	seekTarget(idealFrameNumber, startDts, desiredDts, flags);
+	return ffmpeg::avformat_seek_file(formatCtx, stream, startDts, desiredDts, INT64_MAX, flags) >= 0;
+}
+
+/*! \brief Seek target of a frame
+*
+*	Predict the timestamps to seek to for the desired frame
+*	@param idealFrameNumber number of the desired frame
+*	@param startDts where it stores the min acceptable timestamp
+*	@param desiredDts where it stores the target timestamp
+*	@param flags where it stores the seek flags
+*/
+void ContainerStrategy::seekTarget(const qint64 idealFrameNumber, qint64 &, qint64 &desiredDts, int &flags) const
+{
+	desiredDts = idealFrameNumber;
+	flags = AVSEEK_FLAG_FRAME;
+}
+
+/*! \brief Frame number and time of a timestamp
+*
+*	Frame number and time of a timestamp relative to the first frame
+*	@param ts timestamp in time base units
+*	@param f where it stores the frame number
+*	@param t where it stores the frame time in milliseconds
+*/
+void ContainerStrategy::numberFromTs(const qint64 ts, qint64 &f, qint64 &t) const
+{
+	f = (qint64) (ts * (_timing.frameRate * _timing.timeBase) + 0.5);
+	t = ffmpeg::av_rescale_q(ts, _timing.timeBaseRat, millisecondbase);
+}
+
+
+/**************************************
+**************    AVI    **************
+***************************************/
+
+const char *AviStrategy::getName() const
+{
+	return "avi";
+}
+
+/*! \brief Frame number and time of a packet
+*
+*	dts are already frame numbers
+*/
+void AviStrategy::frameNumberAndTime(const qint64 dts, qint64 &f, qint64 &t) const
+{
+	f = dts;
+	t = ffmpeg::av_rescale_q(dts, _timing.timeBaseRat, millisecondbase);
+}
+
+
+/**************************************
+*************    MPEG    **************
+***************************************/
+
+const char *MpegStrategy::getName() const
+{
+	return "mpeg";
+}
+
+bool MpegStrategy::canSeekByByte() const
+{
+	return true;
+}
+
+/*! \brief Frame number and time of a packet
+*
+*	dts count from the start time of the stream
+*/
+void MpegStrategy::frameNumberAndTime(const qint64 dts, qint64 &f, qint64 &t) const
+{
+	numberFromTs(dts - _timing.startTs, f, t);
+}
+
+/*! \brief Seek target of a frame
+*
+*	One second before the frame, by dts
+*/
+void MpegStrategy::seekTarget(const qint64 idealFrameNumber, qint64 &startDts, qint64 &desiredDts, int &flags) const
+{
+	// ffmpeg bug?: with H.264 avformat_seek_file often seeks not in a keyframe,
+	// thus the following avcodec_decode_video2 iterations may go past desiredDts
+	desiredDts = (idealFrameNumber - 0.5 - _timing.frameRate) / (_timing.frameRate * _timing.timeBase) + _timing.firstDts;
+	if (desiredDts < _timing.firstDts)
+		desiredDts = _timing.firstDts;
+	startDts = -0x7ffffffffffffff;
+	flags = AVSEEK_FLAG_BACKWARD;
+}
+
+
+/**************************************
+**************    ASF    **************
+***************************************/
+
+const char *AsfStrategy::getName() const
+{
+	return "asf";
+}
+
+/*! \brief Frame number and time of a packet
+*
+*	dts count from the start time of the stream
+*/
+void AsfStrategy::frameNumberAndTime(const qint64 dts, qint64 &f, qint64 &t) const
+{
+	numberFromTs(dts - _timing.startTs, f, t);
+}
+
+/*! \brief Seek target of a frame
+*
+*	Time of the frame in ms
+*/
+void AsfStrategy::seekTarget(const qint64 idealFrameNumber, qint64 &, qint64 &desiredDts, int &flags) const
+{
+	desiredDts = idealFrameNumber * _timing.frameMSec;
+	flags = AVSEEK_FLAG_BACKWARD;
+}
+
+
+/**************************************
+**************    MP4    **************
+***************************************/
+
+const char *Mp4Strategy::getName() const
+{
+	return "mp4";
+}
+
+bool Mp4Strategy::hasFirstPacketTiming() const
+{
+	return true;
+}
+
+/*! \brief Frame number and time of a packet
+*
+*	dts are shifted by the first one (negative with B-frames)
+*/
+void Mp4Strategy::frameNumberAndTime(const qint64 dts, qint64 &f, qint64 &t) const
+{
+	numberFromTs(dts + _timing.firstDts, f, t);
+}
+
+/*! \brief Seek to a keyframe before a frame
+*
+*	Seek backward from the time of the frame, based on the real frame ms
+*/
+bool Mp4Strategy::seekToKeyFrame(
+	ffmpeg::AVFormatContext *formatCtx,
+	ffmpeg::AVCodecContext *,
+	const int stream,
+	const qint64 idealFrameNumber
+) const
+{
+	qint64 targetDts = idealFrameNumber * _timing.frameMSecReal;
+	ffmpeg::avformat_seek_file(formatCtx, stream, INT64_MIN, targetDts, INT64_MAX, AVSEEK_FLAG_BACKWARD);
+	return true;
+}
+
+
+/**************************************
+***********    MATROSKA    ************
+***************************************/
+
+const char *MatroskaStrategy::getName() const
+{
+	return "matroska";
+}
+
+bool MatroskaStrategy::hasFirstPacketTiming() const
+{
+	return true;
+}
+
+/*! \brief Frame number and time of a packet
+*
+*	The time counts from the first dts, the frame number is derived from it
+*/
+void MatroskaStrategy::frameNumberAndTime(const qint64 dts, qint64 &f, qint64 &t) const
+{
+	t = ffmpeg::av_rescale_q(dts - _timing.firstDts, _timing.timeBaseRat, millisecondbase);
+	f = round(t / _timing.frameMSec);
+}
+
+/*! \brief Seek to a keyframe before a frame
+*
+*	Seek to the predicted time of the frame, and go back 60 frames at a time
+*	while the demuxer lands after it
+*/
+bool MatroskaStrategy::seekToKeyFrame(
+	ffmpeg::AVFormatContext *formatCtx,
+	ffmpeg::AVCodecContext *codecCtx,
+	const int stream,
+	const qint64 idealFrameNumber
+) const
+{
+	bool reset = false; // used to avoid deadlock situation into the "while"
+
+	// this prediction is not perfect but it gives a good start point close
+	// to the desired frame number
+	// while targetDts is based on the packets DTS, desiredDts is based on
+	// the wanted DTS
+	qint64 targetDts = idealFrameNumber * _timing.chooseMSec;
+	if (ffmpeg::av_seek_frame(formatCtx, stream, targetDts, AVSEEK_FLAG_BACKWARD) < 0) {
+		return false;
+	}
+	ffmpeg::avcodec_flush_buffers(codecCtx);
+	qint64 currDts = formatCtx->streams[stream]->cur_dts;
+
+	while (currDts > targetDts) {
+
+		// if i am after the desired frame, have to reseek
+		targetDts -= (60 * _timing.chooseMSec); // go back of 60frames. TODO: a better value?
+		if (targetDts < 0) {
+			if (reset) {//already resetted before this? Possible deadlock!
+				return true; // false?
+			}
+			targetDts = 0;
+			reset = true;
+		}
+		else {
+			reset = false;
+		}
+
+		if (ffmpeg::av_seek_frame(formatCtx, stream, targetDts, AVSEEK_FLAG_BYTE) < 0) {
+			return false;
+		}
+		ffmpeg::avcodec_flush_buffers(codecCtx);
+		currDts = formatCtx->streams[stream]->cur_dts;
+	}
+	return true;
+}
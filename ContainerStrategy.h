@@ -0,0 +1,119 @@
+#ifndef CONTAINERSTRATEGY_H
+#define CONTAINERSTRATEGY_H
+
+#include <QString>
+
+#include "ffmpeg.h"
+
+//! Timestamps infos of the video stream, as found by QVideoDecoder::openFile
+struct StreamTiming {
+	qint64				startTs = 0;		//!< first real frame ts
+	qint64				firstDts = 0;		//!< dts of first packet
+	double				frameRate = 0;		//!< fps (theorycal)
+	double				frameMSec = 0;		//!< ms of each frame (theorycal)
+	double				frameMSecReal = 0;	//!< ms of each frame (real)
+	double				chooseMSec = 0;		//!< ms of each frame used by mkv seeks
+	double				timeBase = 0;		//!< base time reference
+	ffmpeg::AVRational	timeBaseRat = { 0, 1 };
+};
+
+/*!
+*	@brief Class used to handle the timestamps of a container format
+*
+*	Class used to handle the timestamps of a container format.
+*	Every container numbers its packets in its own way: a strategy turns the
+*	dts of a packet into a frame number and a time, and predicts where to seek
+*	to find a frame when the packets index is not available. The strategy is
+*	chosen once by QVideoDecoder::openFile from the format name, so decoding
+*	never looks at the format again; a new container only needs a new
+*	subclass and a line in create().
+*/
+class ContainerStrategy
+{
+protected:
+	StreamTiming _timing;
+
+	//  Helpers
+	void	numberFromTs(const qint64 ts, qint64 &f, qint64 &t) const;
+
+public:
+
+	virtual ~ContainerStrategy();
+	static ContainerStrategy *create(const QString &formatName);
+
+	void	setTiming(const StreamTiming &timing);
+
+	//  Container properties
+	virtual const char *getName() const = 0;
+	virtual bool	hasFirstPacketTiming() const;
+	virtual bool	canSeekByByte() const;
+
+	//  Timestamps
+	virtual void	frameNumberAndTime(const qint64 dts, qint64 &f, qint64 &t) const = 0;
+	virtual void	seekTarget(const qint64 idealFrameNumber, qint64 &startDts, qint64 &desiredDts, int &flags) const;
+	virtual bool	seekToKeyFrame(
+		ffmpeg::AVFormatContext *formatCtx,
+		ffmpeg::AVCodecContext *codecCtx,
+		const int stream,
+		const qint64 idealFrameNumber
+	) const;
+};
+
+//! avi and any other format: dts are frame numbers
+class AviStrategy : public ContainerStrategy
+{
+public:
+	const char *getName() const;
+	void	frameNumberAndTime(const qint64 dts, qint64 &f, qint64 &t) const;
+};
+
+//! mpeg program streams: dts from the start time, exact byte seeks
+class MpegStrategy : public ContainerStrategy
+{
+public:
+	const char *getName() const;
+	bool	canSeekByByte() const;
+	void	frameNumberAndTime(const qint64 dts, qint64 &f, qint64 &t) const;
+	void	seekTarget(const qint64 idealFrameNumber, qint64 &startDts, qint64 &desiredDts, int &flags) const;
+};
+
+//! asf, wmv: dts from the start time, seeks by ms
+class AsfStrategy : public ContainerStrategy
+{
+public:
+	const char *getName() const;
+	void	frameNumberAndTime(const qint64 dts, qint64 &f, qint64 &t) const;
+	void	seekTarget(const qint64 idealFrameNumber, qint64 &startDts, qint64 &desiredDts, int &flags) const;
+};
+
+//! mov, mp4, 3gp: dts shifted by the first one, timing from the first packet
+class Mp4Strategy : public ContainerStrategy
+{
+public:
+	const char *getName() const;
+	bool	hasFirstPacketTiming() const;
+	void	frameNumberAndTime(const qint64 dts, qint64 &f, qint64 &t) const;
+	bool	seekToKeyFrame(
+		ffmpeg::AVFormatContext *formatCtx,
+		ffmpeg::AVCodecContext *codecCtx,
+		const int stream,
+		const qint64 idealFrameNumber
+	) const;
+};
+
+//! mkv, webm: frame numbers from the time, timing from the first packet
+class MatroskaStrategy : public ContainerStrategy
+{
+public:
+	const char *getName() const;
+	bool	hasFirstPacketTiming() const;
+	void	frameNumberAndTime(const qint64 dts, qint64 &f, qint64 &t) const;
+	bool	seekToKeyFrame(
+		ffmpeg::AVFormatContext *formatCtx,
+		ffmpeg::AVCodecContext *codecCtx,
+		const int stream,
+		const qint64 idealFrameNumber
+	) const;
+};
+
+#endif // CONTAINERSTRATEGY_H
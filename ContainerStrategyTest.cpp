@@ -0,0 +1,211 @@
+/*
+   ShotManager (2015 x64)
+		Luca Gallinari
+		Dario Stabili
+		Marco Ravazzini
+
+	Check of the ContainerStrategy classes: for each container the frame
+	number and time of some packet timestamps and the predicted seek targets
+	are compared with tables of expected values. They only depend on the
+	timestamps infos of the stream, no video file is needed. The seeks of
+	mp4 and mkv need a demuxer and aren't checked here.
+
+*/
+
+#include <QtGlobal>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include "ContainerStrategy.h"
+
+//! Timestamps infos of a kind of stream
+struct TimingCase {
+	const char	*format;		//!< ffmpeg format name
+	const char	*desc;
+	int			tbNum;			//!< time base
+	int			tbDen;
+	int			fpsNum;			//!< frame rate
+	int			fpsDen;
+	qint64		startTs;
+	qint64		firstDts;
+};
+
+enum {
+	AVI_25, AVI_2997, MPEG_25, ASF_25, ASF_2997, MP4_25, MP4_2997, MKV_25, MKV_2997
+};
+
+static const TimingCase timings[] = {
+	{ "avi",			"avi 25 fps",				1, 25,		25, 1,		0, 0 },
+	{ "avi",			"avi 29.97 fps",			1001, 30000, 30000, 1001, 0, 0 },
+	{ "mpeg",			"mpeg 25 fps, B frames",	1, 90000,	25, 1,		48000, 44400 },
+	{ "asf",			"asf 25 fps, preroll",		1, 1000,	25, 1,		3000, 3000 },
+	{ "asf",			"asf 29.97 fps",			1, 1000,	30000, 1001, 0, 0 },
+	{ "mov,mp4,m4a,3gp,3g2,mj2", "mp4 25 fps",		1, 12800,	25, 1,		0, 0 },
+	{ "mov,mp4,m4a,3gp,3g2,mj2", "mp4 29.97 fps",	1, 30000,	30000, 1001, 0, 0 },
+	{ "matroska,webm",	"mkv 25 fps, B frames",		1, 1000,	25, 1,		80, 80 },
+	{ "matroska,webm",	"mkv 29.97 fps",			1, 1000,	30000, 1001, 0, 0 }
+};
+
+//! Frame number and time of a packet timestamp
+struct TimestampCase {
+	int		timing;
+	qint64	dts;
+	qint64	frame;
+	qint64	ms;
+};
+
+static const TimestampCase timestampCases[] = {
+	// dts are frame numbers
+	{ AVI_25,		0,			0,		0 },
+	{ AVI_25,		1,			1,		40 },
+	{ AVI_25,		25,			25,		1000 },
+	{ AVI_25,		90000,		90000,	3600000 },
+	{ AVI_2997,		1,			1,		33 },
+	{ AVI_2997,		30,			30,		1001 },
+
+	// dts from the start time, frame numbers rounded
+	{ MPEG_25,		48000,		0,		0 },
+	{ MPEG_25,		49000,		0,		11 },
+	{ MPEG_25,		51600,		1,		40 },
+	{ MPEG_25,		138000,		25,		1000 },
+	{ MPEG_25,		44400,		0,		-40 },		// B frame before the start
+
+	{ ASF_25,		3000,		0,		0 },
+	{ ASF_25,		3019,		0,		19 },
+	{ ASF_25,		3021,		1,		21 },
+	{ ASF_25,		3040,		1,		40 },
+	{ ASF_25,		4000,		25,		1000 },
+	{ ASF_2997,		33,			1,		33 },
+	{ ASF_2997,		1001,		30,		1001 },
+
+	// dts shifted by the first one
+	{ MP4_25,		0,			0,		0 },
+	{ MP4_25,		512,		1,		40 },
+	{ MP4_25,		12800,		25,		1000 },
+	{ MP4_2997,		1001,		1,		33 },
+	{ MP4_2997,		30030,		30,		1001 },
+
+	// time from the first dts, frame number from the time
+	{ MKV_25,		80,			0,		0 },
+	{ MKV_25,		120,		1,		40 },
+	{ MKV_25,		139,		1,		59 },
+	{ MKV_25,		1080,		25,		1000 },
+	{ MKV_2997,		16,			0,		16 },
+	{ MKV_2997,		17,			1,		17 },
+	{ MKV_2997,		1001,		30,		1001 }
+};
+
+//! Predicted seek of a frame
+struct SeekCase {
+	int		timing;
+	qint64	frame;
+	qint64	startDts;		//!< INT64_MIN when left as it is
+	qint64	desiredDts;
+	int		flags;
+};
+
+static const SeekCase seekCases[] = {
+	// the frame itself
+	{ AVI_25,		0,		INT64_MIN,				0,			AVSEEK_FLAG_FRAME },
+	{ AVI_25,		100,	INT64_MIN,				100,		AVSEEK_FLAG_FRAME },
+	{ AVI_2997,		100,	INT64_MIN,				100,		AVSEEK_FLAG_FRAME },
+
+	// one second before, not before the first dts
+	{ MPEG_25,		10,		-0x7ffffffffffffff,		44400,		AVSEEK_FLAG_BACKWARD },
+	{ MPEG_25,		100,	-0x7ffffffffffffff,		312600,		AVSEEK_FLAG_BACKWARD },
+	{ MPEG_25,		1000,	-0x7ffffffffffffff,		3552600,	AVSEEK_FLAG_BACKWARD },
+
+	// time of the frame
+	{ ASF_25,		0,		INT64_MIN,				0,			AVSEEK_FLAG_BACKWARD },
+	{ ASF_25,		30,		INT64_MIN,				1200,		AVSEEK_FLAG_BACKWARD },
+	{ ASF_2997,		300,	INT64_MIN,				10010,		AVSEEK_FLAG_BACKWARD }
+};
+
+//! Strategy chosen for each format name, and its properties
+struct FormatCase {
+	const char	*format;
+	const char	*strategy;
+	bool		firstPacketTiming;
+	bool		byteSeeks;
+};
+
+static const FormatCase formatCases[] = {
+	{ "avi",						"avi",		false,	false },
+	{ "flv",						"avi",		false,	false },
+	{ "mpeg",						"mpeg",		false,	true },
+	{ "asf",						"asf",		false,	false },
+	{ "mov,mp4,m4a,3gp,3g2,mj2",	"mp4",		true,	false },
+	{ "matroska,webm",				"matroska",	true,	false }
+};
+
+/*! \brief Create the strategy of a timing
+*
+*	Create the strategy of the format of a timing, with the stream infos as
+*	QVideoDecoder::openFile would find them
+*/
+static ContainerStrategy *createStrategy(const TimingCase &c)
+{
+	StreamTiming t;
+	t.startTs = c.startTs;
+	t.firstDts = c.firstDts;
+	t.frameRate = c.fpsNum / (double) c.fpsDen;
+	t.frameMSec = 1000 / t.frameRate;
+	t.frameMSecReal = t.frameMSec;
+	t.chooseMSec = t.frameMSec;
+	t.timeBaseRat.num = c.tbNum;
+	t.timeBaseRat.den = c.tbDen;
+	t.timeBase = c.tbNum / (double) c.tbDen;
+
+	ContainerStrategy *s = ContainerStrategy::create(c.format);
+	s->setTiming(t);
+	return s;
+}
+
+int main()
+{
+	int failed = 0, total = 0;
+
+	for (const FormatCase &c : formatCases) {
+		std::unique_ptr<ContainerStrategy> s(ContainerStrategy::create(c.format));
+		++total;
+		if (
+			strcmp(s->getName(), c.strategy) != 0 ||
+			s->hasFirstPacketTiming() != c.firstPacketTiming || s->canSeekByByte() != c.byteSeeks
+		) {
+			printf("%-24s strategy %s, expected %s  FAILED\n", c.format, s->getName(), c.strategy);
+			++failed;
+		}
+	}
+
+	for (const TimestampCase &c : timestampCases) {
+		std::unique_ptr<ContainerStrategy> s(createStrategy(timings[c.timing]));
+		qint64 f = -1, t = -1;
+		s->frameNumberAndTime(c.dts, f, t);
+		++total;
+		if (f != c.frame || t != c.ms) {
+			printf("%-24s dts %8lld: frame %lld, %lld ms, expected frame %lld, %lld ms  FAILED\n",
+				timings[c.timing].desc, (long long) c.dts, (long long) f, (long long) t,
+				(long long) c.frame, (long long) c.ms);
+			++failed;
+		}
+	}
+
+	for (const SeekCase &c : seekCases) {
+		std::unique_ptr<ContainerStrategy> s(createStrategy(timings[c.timing]));
+		qint64 startDts = INT64_MIN, desiredDts = -1;
+		int flags = -1;
+		s->seekTarget(c.frame, startDts, desiredDts, flags);
+		++total;
+		if (startDts != c.startDts || desiredDts != c.desiredDts || flags != c.flags) {
+			printf("%-24s seek %6lld: dts %lld..%lld flags %d, expected %lld..%lld flags %d  FAILED\n",
+				timings[c.timing].desc, (long long) c.frame,
+				(long long) startDts, (long long) desiredDts, flags,
+				(long long) c.startDts, (long long) c.desiredDts, c.flags);
+			++failed;
+		}
+	}
+
+	printf("%s: %d of %d cases differ\n", failed ? "FAILED" : "OK", failed, total);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,18 @@
+# -------------------------------------------------
+# Check of the container timestamps strategies
+# -------------------------------------------------
+QT       += core
+QT       -= gui
+CONFIG   += c++11 console
+CONFIG   -= app_bundle
+
+TARGET = ContainerStrategyTest
+TEMPLATE = app
+
+SOURCES +=  ContainerStrategyTest.cpp \
+            ContainerStrategy.cpp
+
+HEADERS +=  ContainerStrategy.h \
+            ffmpeg.h
+
+include(ffmpeg.pri)
@@ -0,0 +1,245 @@
+#include "DecoderPool.h"
+
+/*! \brief Create the pool
+*
+*	Create the pool, decoders are opened with open()
+*
+*	@param size number of decoders
+*/
+DecoderPool::DecoderPool(const int size)
+{
+	_info = new QVideoDecoder();
+	for (int i = 0; i < qMax(1, size); ++i)
+		_decoders.push_back(new QVideoDecoder());
+	_busy.assign(_decoders.size(), false);
+	_lastUse.assign(_decoders.size(), 0);
+	_uses = 0;
+	_ok = false;
+	_buildIndex = true;
+}
+
+/*! \brief Destroyer
+*
+*	Destroyer, all the decoders must have been given back
+*/
+DecoderPool::~DecoderPool()
+{
+	for (QVideoDecoder *d : _decoders)
+		delete d;
+	delete _info;
+}
+
+
+/**************************************
+*********    VIDEO ACTIONS    *********
+***************************************/
+
+/*! \brief open a video.
+*
+*   Open the video with all the decoders. Waits for the lent decoders to be
+*	given back first. Several decoders work at the same time, each of them
+*	with a few codec threads by default; the info decoder never decodes and
+*	has a single one.
+*	@param fileName path to the video
+*	@param threading how the codecs spread the decoding over threads
+*	@param threads number of threads of each codec, 0 = one per core
+*	@return success or not
+*/
+bool DecoderPool::open(
+	const QString fileName,
+	const QVideoDecoder::ThreadingMode threading,
+	const int threads
+)
+{
+	// nobody can use the decoders while they are reopened
+	takeAll();
+	_mutex.lock();
+	_ok = false;
+	_mutex.unlock();
+
+	// the first opened builds the index if asked, the others load it
+	_info->setThreading(QVideoDecoder::ThreadingNone);
+	_info->setBuildIndex(_buildIndex);
+	bool ok = _info->openFile(fileName) && _info->isOk();
+	for (QVideoDecoder *d : _decoders) {
+		d->setThreading(threading, threads);
+		d->setBuildIndex(_buildIndex);
+		ok = ok && d->openFile(fileName) && d->isOk();
+	}
+
+	_mutex.lock();
+	_lastUse.assign(_decoders.size(), 0);
+	_mutex.unlock();
+	giveAllBack(ok);
+	return ok;
+}
+
+/*! \brief Build the packets index when opening
+*
+*   Let the decoders build the packets index of the video when opening it
+*	(the first one builds it, the others load the sidecar file it stored),
+*	or only load it. Used from the next opened video.
+*	@param enable build the index or only load it
+*	@see QVideoDecoder::setBuildIndex()
+*/
+void DecoderPool::setBuildIndex(const bool enable)
+{
+	_buildIndex = enable;
+}
+
+/*! \brief Set the packets index
+*
+*   Give the packets index of the open video to all the decoders, e.g. once
+*	it has been built in background. Waits for the lent decoders to be given
+*	back first.
+*	@param index the index
+*	@return success or not
+*/
+bool DecoderPool::setIndex(const FrameIndex &index)
+{
+	if (!isOk())
+		return false;
+
+	takeAll();
+	bool ok = _info->setIndex(index);
+	for (QVideoDecoder *d : _decoders)
+		ok = d->setIndex(index) && ok;
+	giveAllBack(true);
+	return ok;
+}
+
+
+/**************************************
+*********   DECODER ACTIONS   *********
+***************************************/
+
+/*! \brief take a decoder
+*
+*   Take the free decoder that reaches the given frame with the least work,
+*	waiting for one to be given back if all are lent. It must be given back
+*	with release().
+*	@param frame frame number the decoder is going to be used for
+*	@return the decoder, null if no video is open
+*/
+QVideoDecoder *DecoderPool::acquire(const qint64 frame)
+{
+	QMutexLocker locker(&_mutex);
+
+	forever {
+		if (!_ok)
+			return 0;
+
+		int best = -1;
+		qint64 bestDistance = -1;
+		for (size_t i = 0; i < _decoders.size(); ++i) {
+			if (_busy[i])
+				continue;
+
+			// decoding forward is never worse than seeking, among decoders
+			// that must seek keep the recently used positions
+			qint64 d = _decoders[i]->getForwardDistance(frame);
+			bool better = (best == -1) ||
+				(d >= 0 && (bestDistance < 0 || d < bestDistance)) ||
+				(d < 0 && bestDistance < 0 && _lastUse[i] < _lastUse[best]);
+			if (better) {
+				best = i;
+				bestDistance = d;
+			}
+		}
+
+		if (best != -1) {
+			_busy[best] = true;
+			_lastUse[best] = ++_uses;
+			return _decoders[best];
+		}
+		_freeCond.wait(&_mutex);
+	}
+}
+
+/*! \brief give a decoder back
+*
+*   Give back a decoder taken with acquire()
+*	@param decoder the decoder
+*/
+void DecoderPool::release(QVideoDecoder *decoder)
+{
+	QMutexLocker locker(&_mutex);
+
+	for (size_t i = 0; i < _decoders.size(); ++i) {
+		if (_decoders[i] == decoder) {
+			_busy[i] = false;
+			_freeCond.wakeAll();
+			return;
+		}
+	}
+}
+
+
+/**************************************
+************    HELPERS    ************
+***************************************/
+
+/*! \brief take all the decoders
+*
+*   Take all the decoders, waiting for the lent ones to be given back
+*/
+void DecoderPool::takeAll()
+{
+	QMutexLocker locker(&_mutex);
+
+	for (size_t i = 0; i < _decoders.size(); ++i) {
+		while (_busy[i])
+			_freeCond.wait(&_mutex);
+		_busy[i] = true;
+	}
+}
+
+/*! \brief give all the decoders back
+*
+*   Give back all the decoders taken with takeAll()
+*	@param ok the video is open
+*/
+void DecoderPool::giveAllBack(const bool ok)
+{
+	QMutexLocker locker(&_mutex);
+
+	_ok = ok;
+	_busy.assign(_decoders.size(), false);
+	_freeCond.wakeAll();
+}
+
+
+/**************************************
+*********        GETTERS      *********
+***************************************/
+
+/*! \brief Get the video properties
+*
+*	Get a decoder to read the properties of the video (length, frame rate,
+*	metadata...). It is never lent, so it can be read while the others are
+*	decoding, from the thread that opens the pool. It must not be used to
+*	decode.
+*/
+QVideoDecoder *DecoderPool::getInfo()
+{
+	return _info;
+}
+
+/*! \brief a video is open?
+*
+*   Checks if the video has been opened by all the decoders
+*/
+bool DecoderPool::isOk()
+{
+	QMutexLocker locker(&_mutex);
+	return _ok;
+}
+
+/*! \brief Get pool size
+*
+*	Retrieve the number of decoders
+*/
+int DecoderPool::size()
+{
+	return _decoders.size();
+}
@@ -0,0 +1,68 @@
+#ifndef DECODERPOOL_H
+#define DECODERPOOL_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <vector>
+
+#include "QVideoDecoder.h"
+
+#define DECODERPOOL_DEFAULT_SIZE	4	// buffer, prefetcher, seeker and one spare
+#define DECODERPOOL_THREADS			2	// codec threads of each decoder, a few decode at the same time
+
+/*!
+*	@brief Class used to share independent decoders of the same video
+*
+*	Class used to share independent decoders of the same video.
+*	Every decoder has its own demuxer and codec, so the buffer and the
+*	background decoding can work in parallel without moving each other's
+*	position. A decoder is lent for a frame: the pool gives the free one that
+*	reaches it decoding the fewest frames (the one already in its GOP, just
+*	before it), and when all of them have to seek the least recently used
+*	one, so the positions used lately are kept.
+*	Decoders can be taken and given back from any thread. The properties of
+*	the video are read from one more decoder that is never lent.
+*/
+class DecoderPool
+{
+	QVideoDecoder			*_info;		//!< never lent, gives the video properties
+
+	QMutex					_mutex;		//!< protects all the variables below
+	QWaitCondition			_freeCond;	//!< a decoder has been given back
+
+	std::vector<QVideoDecoder *>	_decoders;
+	std::vector<bool>		_busy;		//!< lent decoders
+	std::vector<quint64>	_lastUse;	//!< when each decoder was lent
+	quint64					_uses;		//!< number of decoders lent so far
+	bool					_ok;		//!< the video is open
+	bool					_buildIndex;	//!< open builds the missing packets index
+
+	//  Helpers
+	void	takeAll();
+	void	giveAllBack(const bool ok);
+
+public:
+
+	DecoderPool(const int size = DECODERPOOL_DEFAULT_SIZE);
+	~DecoderPool();
+
+	//  Video actions
+	bool open(
+		const QString fileName,
+		const QVideoDecoder::ThreadingMode threading = QVideoDecoder::ThreadingAuto,
+		const int threads = DECODERPOOL_THREADS
+	);
+	void setBuildIndex(const bool enable);
+	bool setIndex(const FrameIndex &index);
+
+	//  Decoder actions
+	QVideoDecoder	*acquire(const qint64 frame);
+	void			release(QVideoDecoder *decoder);
+
+	//  Getters
+	QVideoDecoder	*getInfo();
+	bool			isOk();
+	int				size();
+};
+
+#endif // DECODERPOOL_H
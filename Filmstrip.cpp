@@ -0,0 +1,314 @@
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QBuffer>
+#include <QDebug>
+
+#include "Filmstrip.h"
+
+#define FILMSTRIP_MAGIC		0x534d4653	// "SMFS"
+#define FILMSTRIP_VERSION	2			// 2: frames numbered on the timeline
+#define FILMSTRIP_MIN_ENTRY	20			// bytes of a stored thumbnail at least: number, time, jpeg size
+
+/*! \brief Create the filmstrip
+*
+*	Create an empty filmstrip, the pass starts when a video is opened
+*
+*	@param thumbSize box the thumbnails fit in
+*/
+Filmstrip::Filmstrip(const QSize &thumbSize) : _thumbSize(thumbSize)
+{
+	_complete = false;
+	_abort = false;
+}
+
+/*! \brief Destroyer
+*
+*	Stop the pass and wait for it
+*/
+Filmstrip::~Filmstrip()
+{
+	clear();
+}
+
+/*! \brief Path of the sidecar file
+*
+*	Path of the sidecar file where the filmstrip of the given video is stored.
+*	@param fileName path of the video
+*	@return path of the filmstrip
+*/
+QString Filmstrip::sidecarPath(const QString &fileName)
+{
+	return fileName + ".smstrip";
+}
+
+/*! \brief Worker loop
+*
+*	Load the thumbnails from the sidecar file or, when it is missing or
+*	outdated, decode all the keyframes of the video at the thumbnail size and
+*	store them at the end. Each thumbnail is published as soon as it is ready.
+*/
+void Filmstrip::run()
+{
+	// stored by a previous pass? a file that can't be read entirely is made again
+	bool loaded = load();
+	_mutex.lock();
+	bool aborted = _abort;
+	if (!loaded)
+		_frames.clear();
+	_complete = loaded && !aborted;
+	_mutex.unlock();
+	if (loaded || aborted)
+		return;
+
+	QVideoDecoder decoder;
+	decoder.setKeyFramesOnly(true);
+	decoder.setBuildIndex(false);
+	decoder.setThreading(QVideoDecoder::ThreadingNone);	// keyframes only, in background
+	decoder.setOutputSize(_size.width(), _size.height());
+
+	// numbered as the frames of the player, even if the index couldn't be
+	// stored next to the video
+	bool ok = decoder.openFile(_fileName) && decoder.isOk();
+	if (ok && _index.isValid())
+		decoder.setIndex(_index);
+	ok = ok && decoder.seekFrame(0);
+	while (ok) {
+		Frame f;
+		bool got = decoder.getFrame(f.img, &f.num, &f.time);
+
+		_mutex.lock();
+		if (_abort)
+			ok = false;
+		else if (got && (_frames.empty() || f.num > _frames.back().num))
+			_frames.push_back(f);
+		_mutex.unlock();
+
+		if (ok)
+			ok = decoder.readNextFrame();
+	}
+	decoder.close();
+
+	_mutex.lock();
+	aborted = _abort;
+	_complete = !aborted;
+	_mutex.unlock();
+
+	// not being able to write next to the video is not an error
+	if (!aborted && !save())
+		qDebug() << "Can't store the filmstrip in" << sidecarPath(_fileName);
+}
+
+
+/**************************************
+*********    VIDEO ACTIONS    *********
+***************************************/
+
+/*! \brief open a video
+*
+*	Start loading the filmstrip of the video from its sidecar file, or the
+*	pass that makes it when it is missing or outdated, in background.
+*	@param fileName path of the video
+*	@param frameSize size of the video frames
+*	@param index packets index of the video, the one of the decoders of
+*		the player, not valid if it isn't available
+*/
+void Filmstrip::open(const QString fileName, const QSize &frameSize, const FrameIndex &index)
+{
+	clear();
+
+	_fileName = fileName;
+	_index = index;
+	_size = frameSize.scaled(_thumbSize, Qt::KeepAspectRatio);
+	if (_size.isEmpty())
+		return;
+
+	start(QThread::LowPriority);
+}
+
+/*! \brief clear the filmstrip
+*
+*	Stop the pass, if any, and drop the thumbnails
+*/
+void Filmstrip::clear()
+{
+	_mutex.lock();
+	_abort = true;
+	_mutex.unlock();
+
+	wait();
+
+	_index.clear();
+	_mutex.lock();
+	_frames.clear();
+	_complete = false;
+	_abort = false;
+	_mutex.unlock();
+}
+
+
+/**************************************
+*********    FRAME ACTIONS    *********
+***************************************/
+
+/*! \brief get the thumbnail nearest to a frame
+*
+*	Get the thumbnail of the last keyframe placed before (or on) the given
+*	frame, the one a seek would decode first.
+*	@param num frame number
+*	@param f where the thumbnail will be stored
+*	@return success or not, false when no keyframe before it is known yet
+*/
+bool Filmstrip::getNearest(const qint64 num, Frame &f)
+{
+	QMutexLocker locker(&_mutex);
+
+	int i = findFrame(num);
+	if (i == -1)
+		return false;
+	f = _frames[i];
+	return true;
+}
+
+
+/**************************************
+************    HELPERS    ************
+***************************************/
+
+/*! \brief Find the keyframe of a frame
+*
+*	Binary search of the last keyframe whose number is <= the given one, must
+*	be called with the mutex locked.
+*	@param num frame number
+*	@return position in the filmstrip, -1 if there isn't
+*/
+int Filmstrip::findFrame(const qint64 num)
+{
+	int lo = 0, hi = _frames.size();
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (_frames[mid].num <= num)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo - 1;
+}
+
+/*! \brief Load the filmstrip from its sidecar file
+*
+*	Load the filmstrip from its sidecar file, publishing each thumbnail as
+*	soon as it is decompressed. It is discarded if the video has been
+*	modified after it was created or if the thumbnails size changed.
+*	@return success or not, false when aborted
+*/
+bool Filmstrip::load()
+{
+	QFileInfo info(_fileName);
+	QFile file(sidecarPath(_fileName));
+	if (!info.exists() || !file.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream in(&file);
+	in.setByteOrder(QDataStream::LittleEndian);
+
+	quint32 magic, version;
+	qint64 fileSize, fileTime;
+	qint32 width, height, count;
+	in >> magic >> version >> fileSize >> fileTime >> width >> height >> count;
+
+	if (
+		in.status() != QDataStream::Ok ||
+		magic != FILMSTRIP_MAGIC || version != FILMSTRIP_VERSION ||
+		fileSize != info.size() || fileTime != info.lastModified().toMSecsSinceEpoch() ||
+		width != _size.width() || height != _size.height() || count <= 0 ||
+		count > (file.size() - file.pos()) / FILMSTRIP_MIN_ENTRY
+	)
+		return false;	// a corrupted count could ask for any amount of memory
+
+	for (qint32 i = 0; i < count; ++i) {
+		Frame f;
+		QByteArray jpeg;
+		in >> f.num >> f.time >> jpeg;
+		if (in.status() != QDataStream::Ok || !f.img.loadFromData(jpeg, "JPG"))
+			return false;
+		f.img = f.img.convertToFormat(QImage::Format_RGB32);
+
+		// in order, the lookups are binary searches
+		QMutexLocker locker(&_mutex);
+		if (_abort || (!_frames.empty() && f.num <= _frames.back().num))
+			return false;
+		_frames.push_back(f);
+	}
+	return true;
+}
+
+/*! \brief Store the filmstrip in its sidecar file
+*
+*	Store the thumbnails, compressed as jpeg, in the sidecar file.
+*	@return success or not
+*/
+bool Filmstrip::save()
+{
+	// the images are shared, the copy is cheap and the lookups don't wait
+	// for the compression
+	_mutex.lock();
+	std::vector<Frame> frames = _frames;
+	_mutex.unlock();
+
+	QFileInfo info(_fileName);
+	if (frames.empty() || !info.exists())
+		return false;
+
+	QFile file(sidecarPath(_fileName));
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	QDataStream out(&file);
+	out.setByteOrder(QDataStream::LittleEndian);
+
+	out << (quint32) FILMSTRIP_MAGIC << (quint32) FILMSTRIP_VERSION
+		<< info.size() << info.lastModified().toMSecsSinceEpoch()
+		<< (qint32) _size.width() << (qint32) _size.height() << (qint32) frames.size();
+
+	for (const Frame &f : frames) {
+		QByteArray jpeg;
+		QBuffer buffer(&jpeg);
+		buffer.open(QIODevice::WriteOnly);
+		f.img.save(&buffer, "JPG", FILMSTRIP_QUALITY);
+		out << f.num << f.time << jpeg;
+	}
+
+	if (out.status() != QDataStream::Ok) {
+		file.close();
+		file.remove();
+		return false;
+	}
+	return true;
+}
+
+
+/**************************************
+*********        GETTERS      *********
+***************************************/
+
+/*! \brief the filmstrip is complete?
+*
+*	All the keyframes of the video are in the filmstrip
+*/
+bool Filmstrip::isComplete()
+{
+	QMutexLocker locker(&_mutex);
+	return _complete;
+}
+
+/*! \brief Get number of thumbnails
+*
+*	Retrieve the number of keyframes in the filmstrip so far
+*/
+int Filmstrip::size()
+{
+	QMutexLocker locker(&_mutex);
+	return _frames.size();
+}
@@ -0,0 +1,69 @@
+#ifndef FILMSTRIP_H
+#define FILMSTRIP_H
+
+#include <QThread>
+#include <QMutex>
+#include <QImage>
+#include <vector>
+
+#include "QVideoDecoder.h"
+#include "FrameIndex.h"
+#include "Frame.h"
+
+#define FILMSTRIP_THUMB_W	160		// width of the filmstrip thumbnails
+#define FILMSTRIP_THUMB_H	90		// height of the filmstrip thumbnails
+#define FILMSTRIP_QUALITY	80		// jpeg quality of the stored thumbnails
+
+/*!
+*	@brief Thread used to make thumbnails of all the keyframes of a video
+*
+*	Thread used to make thumbnails of all the keyframes of a video, used for
+*	coarse navigation: the nearest keyframe of any position is shown at once,
+*	without decoding anything, while the exact frame is decoded.
+*	A single pass reads the whole video with its own QVideoDecoder which
+*	gives only the keyframes to the codec and scales them directly to the
+*	thumbnail size. Thumbnails can be looked up while the pass goes on.
+*	At the end they are stored, as jpeg, in a sidecar file next to the video
+*	(video.smstrip), so the pass runs only the first time a video is opened;
+*	the next times the same thread loads them from there.
+*/
+class Filmstrip : public QThread
+{
+	QString			_fileName;		//!< video of the filmstrip
+	QSize			_thumbSize;		//!< box the thumbnails fit in
+	QSize			_size;			//!< size of the thumbnails of the video
+	FrameIndex		_index;			//!< packets index the frames are numbered with
+
+	QMutex			_mutex;			//!< protects all the variables below
+	std::vector<Frame> _frames;	//!< thumbnails by frame number
+	bool			_complete;		//!< all the keyframes are in
+	bool			_abort;			//!< stop the pass
+
+	//  Helpers
+	bool	load();
+	bool	save();
+	int		findFrame(const qint64 num);
+
+protected:
+	void run();
+
+public:
+
+	Filmstrip(const QSize &thumbSize = QSize(FILMSTRIP_THUMB_W, FILMSTRIP_THUMB_H));
+	~Filmstrip();
+
+	//  Video actions
+	void	open(const QString fileName, const QSize &frameSize, const FrameIndex &index);
+	void	clear();
+
+	//  Frame actions
+	bool	getNearest(const qint64 num, Frame &f);
+
+	//  Getters
+	bool	isComplete();
+	int		size();
+
+	static QString sidecarPath(const QString &fileName);
+};
+
+#endif // FILMSTRIP_H
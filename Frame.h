@@ -0,0 +1,26 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <QImage>
+
+/*!
+*	@brief Decoded frame: its pixels and its position in the video
+*
+*	Handle of a decoded frame, passed by value from the decoder threads to the
+*	GUI: the prefetcher, the seeker, the playback engine, the filmstrip, the
+*	buffer ring, the cache, the signals and the surfaces all hold copies of
+*	the same handle.
+*	The pixels are an implicitly shared QImage: copying a Frame only bumps an
+*	atomic reference count, so handles can cross threads, and the image is
+*	never written once decoded (a write would detach a private copy, it can't
+*	change what the other holders see). QImage is painted directly, so no
+*	QPixmap, which can't be created outside the GUI thread and would copy the
+*	pixels, is ever built from it.
+*/
+struct Frame {
+	QImage img;
+	qint64 num = -1;		//!< absolute frame number
+	qint64 time = -1;		//!< frame timestamp
+};
+
+#endif // FRAME_H
@@ -0,0 +1,202 @@
+
+#include "FrameCache.h"
+
+/*! \brief Create the cache
+*
+*	Create an empty cache
+*
+*	@param budget max number of bytes used by the cached images
+*/
+FrameCache::FrameCache(const qint64 budget) : _budget(budget)
+{
+	_used = 0;
+}
+
+/*! \brief Destroyer
+*
+*	Destroyer
+*/
+FrameCache::~FrameCache()
+{
+	clear();
+}
+
+
+/**************************************
+*********    FRAME ACTIONS    *********
+***************************************/
+
+/*! \brief retrieve a cached frame
+*
+*	Retrieve a cached frame and mark it as the most recently used.
+*	@param num frame number
+*	@param f where the frame will be stored
+*	@return the frame was cached or not
+*/
+bool FrameCache::get(const qint64 num, Frame &f)
+{
+	QHash<qint64, Entry>::iterator it = _frames.find(num);
+	if (it == _frames.end())
+		return false;
+
+	std::list<qint64> &lru = it->pinned ? _pinnedLru : _lru;
+	lru.splice(lru.begin(), lru, it->lru);
+	f = it->f;
+	return true;
+}
+
+/*! \brief cache a frame
+*
+*	Store a frame as the most recently used, dropping the least recently used
+*	ones if the budget is exceeded. Frames bigger than the whole budget are
+*	not cached.
+*	@param f frame, its number is the key
+*/
+void FrameCache::insert(const Frame &f)
+{
+	if (f.num < 0 || f.img.isNull())
+		return;
+
+	remove(f.num);
+
+	qint64 bytes = frameBytes(f);
+	if (bytes > _budget)
+		return;
+
+	Entry e;
+	e.f = f;
+	e.bytes = bytes;
+	e.pinned = _pins.contains(f.num);
+	std::list<qint64> &lru = e.pinned ? _pinnedLru : _lru;
+	lru.push_front(f.num);
+	e.lru = lru.begin();
+
+	_frames.insert(f.num, e);
+	_used += bytes;
+	evict();
+}
+
+/*! \brief pin frames
+*
+*	Replace the set of pinned frames. Pinned frames are dropped only when the
+*	unpinned ones are not enough to stay under the budget. The frames don't
+*	need to be cached yet: they will be pinned as soon as they are inserted.
+*	@param nums frame numbers to pin
+*/
+void FrameCache::setPinnedFrames(const QSet<qint64> &nums)
+{
+	_pins = nums;
+
+	// move the cached frames to the right LRU list, keeping their order
+	QHash<qint64, Entry>::iterator it;
+	for (it = _frames.begin(); it != _frames.end(); ++it) {
+		bool pinned = _pins.contains(it.key());
+		if (pinned == it->pinned)
+			continue;
+		std::list<qint64> &from = it->pinned ? _pinnedLru : _lru;
+		std::list<qint64> &to = pinned ? _pinnedLru : _lru;
+		to.splice(to.end(), from, it->lru);
+		it->pinned = pinned;
+	}
+	evict();
+}
+
+/*! \brief change the budget
+*
+*	Change the max number of bytes used by the cached images.
+*	@param budget max number of bytes
+*/
+void FrameCache::setBudget(const qint64 budget)
+{
+	_budget = budget;
+	evict();
+}
+
+/*! \brief empty the cache
+*
+*	Drop all the cached frames. Pins are kept.
+*/
+void FrameCache::clear()
+{
+	_frames.clear();
+	_lru.clear();
+	_pinnedLru.clear();
+	_used = 0;
+}
+
+
+/**************************************
+************    HELPERS    ************
+***************************************/
+
+/*! \brief drop frames over budget
+*
+*	Drop the least recently used frames until the budget is respected,
+*	unpinned frames first.
+*/
+void FrameCache::evict()
+{
+	while (_used > _budget && !_lru.empty())
+		remove(_lru.back());
+	while (_used > _budget && !_pinnedLru.empty())
+		remove(_pinnedLru.back());
+}
+
+/*! \brief drop a frame
+*
+*	Drop a frame from the cache, if present.
+*	@param num frame number
+*/
+void FrameCache::remove(const qint64 num)
+{
+	QHash<qint64, Entry>::iterator it = _frames.find(num);
+	if (it == _frames.end())
+		return;
+
+	(it->pinned ? _pinnedLru : _lru).erase(it->lru);
+	_used -= it->bytes;
+	_frames.erase(it);
+}
+
+/*! \brief memory used by a frame
+*
+*	Memory used by the image of a frame, with the padding of its rows.
+*	@param f frame
+*	@return bytes
+*/
+qint64 FrameCache::frameBytes(const Frame &f)
+{
+	return (qint64) f.img.bytesPerLine() * f.img.height();
+}
+
+
+/**************************************
+*********        GETTERS      *********
+***************************************/
+
+/*! \brief Get budget
+*
+*	Retrieve the max number of bytes used by the cached images
+*/
+qint64 FrameCache::getBudget()
+{
+	return _budget;
+}
+
+/*! \brief Get used bytes
+*
+*	Retrieve the number of bytes used by the cached images
+*/
+qint64 FrameCache::getUsedBytes()
+{
+	return _used;
+}
+
+/*! \brief Get number of frames
+*
+*	Retrieve the number of cached frames
+*/
+int FrameCache::size()
+{
+	return _frames.size();
+}
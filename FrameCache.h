@@ -0,0 +1,62 @@
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include <QHash>
+#include <QSet>
+#include <list>
+
+#include "Frame.h"
+
+/*!
+*	@brief Class used to keep decoded frames across seeks
+*
+*	Class used to keep decoded frames across seeks.
+*	Frames are stored by frame number until their total size reaches a byte
+*	budget, then the least recently used ones are dropped.
+*	Frames can be pinned (e.g. the ones around the markers boundaries): they
+*	are kept in a second LRU list that is evicted only when the unpinned
+*	frames alone are not enough to stay under the budget.
+*	Frames are shared handles, so a frame that is both in the cache and in
+*	the ImagesBuffer ring is stored only once.
+*/
+class FrameCache
+{
+	//! Cached frame
+	struct Entry {
+		Frame	f;
+		qint64	bytes;						//!< size of the image
+		bool	pinned;
+		std::list<qint64>::iterator lru;	//!< position in its LRU list
+	};
+
+	QHash<qint64, Entry>	_frames;		//!< cached frames by number
+	std::list<qint64>		_lru;			//!< unpinned frames, most recent first
+	std::list<qint64>		_pinnedLru;		//!< pinned frames, most recent first
+	QSet<qint64>			_pins;			//!< pinned frame numbers
+	qint64					_budget;		//!< max bytes
+	qint64					_used;			//!< bytes in use
+
+	//  Helpers
+	void	evict();
+	void	remove(const qint64 num);
+	static qint64 frameBytes(const Frame &f);
+
+public:
+
+	FrameCache(const qint64 budget);
+	~FrameCache();
+
+	//  Frame actions
+	bool	get(const qint64 num, Frame &f);
+	void	insert(const Frame &f);
+	void	setPinnedFrames(const QSet<qint64> &nums);
+	void	setBudget(const qint64 budget);
+	void	clear();
+
+	//  Getters
+	qint64	getBudget();
+	qint64	getUsedBytes();
+	int		size();
+};
+
+#endif // FRAMECACHE_H
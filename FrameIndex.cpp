@@ -0,0 +1,334 @@
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QDebug>
+
+#include "FrameIndex.h"
+
+#define FRAMEINDEX_MAGIC	0x534d4958	// "SMIX"
+#define FRAMEINDEX_VERSION	1
+
+/*! \brief Create an empty index
+*
+*	Create an empty index
+*/
+FrameIndex::FrameIndex()
+{
+	clear();
+}
+
+/*! \brief Destroyer
+*
+*	Destroyer
+*/
+FrameIndex::~FrameIndex()
+{
+	clear();
+}
+
+/*! \brief Path of the sidecar file
+*
+*	Path of the sidecar file where the index of the given video is stored.
+*	@param fileName path of the video
+*	@return path of the index
+*/
+QString FrameIndex::sidecarPath(const QString &fileName)
+{
+	return fileName + ".smidx";
+}
+
+
+/**************************************
+*********    INDEX ACTIONS    *********
+***************************************/
+
+/*! \brief Stop a build
+*
+*	Interrupt callback of the demuxer of build(): tells it to give up its
+*	current read when the build is aborted
+*	@param abort abort flag of the build, can be null
+*/
+static int interruptBuild(void *abort)
+{
+	return abort && ((const QAtomicInt *) abort)->load();
+}
+
+/*! \brief Build the index of the video stream
+*
+*	Read every packet of the file without decoding it and store the
+*	informations of the ones belonging to the given stream. The file is opened
+*	with its own format context so the caller's demuxer position is untouched.
+*	@param fileName path of the video
+*	@param streamIndex index of the video stream
+*	@param abort when not null, the build stops as soon as it is set, e.g.
+*		from another thread, and fails
+*	@return success or not
+*/
+bool FrameIndex::build(const QString &fileName, const int streamIndex, const QAtomicInt *abort)
+{
+	clear();
+
+	if (!readFileInfo(fileName))
+		return false;
+
+	ffmpeg::AVFormatContext *ctx = ffmpeg::avformat_alloc_context();
+	if (!ctx)
+		return false;
+	ctx->interrupt_callback.callback = interruptBuild;
+	ctx->interrupt_callback.opaque = (void *) abort;
+	if (ffmpeg::avformat_open_input(&ctx, fileName.toStdString().c_str(), NULL, NULL) != 0)
+		return false;
+
+	if (streamIndex < 0 || streamIndex >= (int) ctx->nb_streams) {
+		ffmpeg::avformat_close_input(&ctx);
+		return false;
+	}
+
+	// we don't need any other stream, let the demuxer skip them
+	for (unsigned i = 0; i < ctx->nb_streams; ++i) {
+		if ((int) i != streamIndex)
+			ctx->streams[i]->discard = ffmpeg::AVDISCARD_ALL;
+	}
+
+	ffmpeg::AVPacket packet;
+	while (!interruptBuild((void *) abort) && ffmpeg::av_read_frame(ctx, &packet) >= 0) {
+		if (packet.stream_index == streamIndex) {
+			FrameIndexEntry e;
+			e.pts		= packet.pts;
+			e.dts		= packet.dts;
+			e.pos		= packet.pos;
+			e.flags		= packet.flags;
+			e.duration	= packet.duration;
+			_entries.push_back(e);
+		}
+		ffmpeg::av_free_packet(&packet);
+	}
+	ffmpeg::avformat_close_input(&ctx);
+
+	// a part of the packets is not an index
+	if (interruptBuild((void *) abort)) {
+		clear();
+		return false;
+	}
+
+	_stream = streamIndex;
+	updateKeyFrames();
+
+	qDebug() << "Index built:" << _entries.size() << "packets," << _keys.size() << "keyframes";
+	return isValid();
+}
+
+/*! \brief Load the index from its sidecar file
+*
+*	Load the index from its sidecar file. The index is discarded if the video
+*	has been modified after the index was created.
+*	@param fileName path of the video
+*	@param streamIndex index of the video stream
+*	@return success or not
+*/
+bool FrameIndex::load(const QString &fileName, const int streamIndex)
+{
+	clear();
+
+	if (!readFileInfo(fileName))
+		return false;
+
+	QFile file(sidecarPath(fileName));
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream in(&file);
+	in.setByteOrder(QDataStream::LittleEndian);
+
+	quint32 magic, version;
+	qint64 fileSize, fileTime;
+	qint32 stream, count;
+	in >> magic >> version >> fileSize >> fileTime >> stream >> count;
+
+	if (
+		in.status() != QDataStream::Ok ||
+		magic != FRAMEINDEX_MAGIC || version != FRAMEINDEX_VERSION ||
+		fileSize != _fileSize || fileTime != _fileTime ||
+		stream != streamIndex || count <= 0 ||
+		count > (file.size() - file.pos()) / (qint64) sizeof(FrameIndexEntry)
+	) {
+		// a truncated or corrupted file can't claim more entries than it holds
+		clear();
+		return false;
+	}
+
+	_entries.resize(count);
+	const qint64 bytes = (qint64) count * sizeof(FrameIndexEntry);
+	if (file.read((char *) &_entries[0], bytes) != bytes) {
+		clear();
+		return false;
+	}
+
+	_stream = streamIndex;
+	updateKeyFrames();
+	return isValid();
+}
+
+/*! \brief Store the index in its sidecar file
+*
+*	Store the index in its sidecar file.
+*	@param fileName path of the video
+*	@return success or not
+*/
+bool FrameIndex::save(const QString &fileName)
+{
+	if (!isValid())
+		return false;
+
+	QFile file(sidecarPath(fileName));
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	QDataStream out(&file);
+	out.setByteOrder(QDataStream::LittleEndian);
+
+	out << (quint32) FRAMEINDEX_MAGIC << (quint32) FRAMEINDEX_VERSION
+		<< _fileSize << _fileTime << (qint32) _stream << (qint32) _entries.size();
+
+	const qint64 bytes = (qint64) _entries.size() * sizeof(FrameIndexEntry);
+	if (out.status() != QDataStream::Ok || file.write((const char *) &_entries[0], bytes) != bytes) {
+		file.close();
+		file.remove();
+		return false;
+	}
+	return out.status() == QDataStream::Ok;
+}
+
+/*! \brief Load the index or build it
+*
+*	Load the index from its sidecar file, if it is missing or outdated build
+*	it and store it for the next time.
+*	@param fileName path of the video
+*	@param streamIndex index of the video stream
+*	@return success or not
+*/
+bool FrameIndex::loadOrBuild(const QString &fileName, const int streamIndex)
+{
+	if (load(fileName, streamIndex))
+		return true;
+
+	if (!build(fileName, streamIndex))
+		return false;
+
+	// not being able to write next to the video is not an error
+	if (!save(fileName))
+		qDebug() << "Can't store the index in" << sidecarPath(fileName);
+	return true;
+}
+
+/*! \brief Clear the index
+*
+*	Clear the index
+*/
+void FrameIndex::clear()
+{
+	_entries.clear();
+	_keys.clear();
+	_fileSize = -1;
+	_fileTime = -1;
+	_stream = -1;
+}
+
+
+/**************************************
+************    HELPERS    ************
+***************************************/
+
+/*! \brief Collect the keyframes
+*
+*	Collect the indexes of the keyframe packets with a valid timestamp.
+*/
+void FrameIndex::updateKeyFrames()
+{
+	_keys.clear();
+	for (int i = 0; i < (int) _entries.size(); ++i) {
+		const FrameIndexEntry &e = _entries[i];
+		if ((e.flags & AV_PKT_FLAG_KEY) && (e.dts != AV_NOPTS_VALUE || e.pts != AV_NOPTS_VALUE))
+			_keys.push_back(i);
+	}
+}
+
+/*! \brief Read size and modification time of the video
+*
+*	Read size and modification time of the video, used to check that the
+*	sidecar file still refers to the same video.
+*	@param fileName path of the video
+*	@return file exists or not
+*/
+bool FrameIndex::readFileInfo(const QString &fileName)
+{
+	QFileInfo info(fileName);
+	if (!info.exists())
+		return false;
+	_fileSize = info.size();
+	_fileTime = info.lastModified().toMSecsSinceEpoch();
+	return true;
+}
+
+
+/**************************************
+*********        GETTERS      *********
+***************************************/
+
+/*! \brief The index is usable?
+*
+*	The index contains at least a keyframe
+*/
+bool FrameIndex::isValid()
+{
+	return !_keys.empty();
+}
+
+/*! \brief Get number of packets
+*
+*	Retrieve the number of indexed packets
+*/
+int FrameIndex::size()
+{
+	return _entries.size();
+}
+
+/*! \brief Get number of keyframes
+*
+*	Retrieve the number of indexed keyframes
+*/
+int FrameIndex::numKeyFrames()
+{
+	return _keys.size();
+}
+
+/*! \brief Get the indexed stream
+*
+*	Retrieve the index of the indexed stream, -1 if the index is empty
+*/
+int FrameIndex::stream()
+{
+	return _stream;
+}
+
+/*! \brief Get a packet
+*
+*	Retrieve a packet by its decoding order
+*	@param i packet position
+*/
+const FrameIndexEntry &FrameIndex::at(const int i)
+{
+	return _entries[i];
+}
+
+/*! \brief Get a keyframe
+*
+*	Retrieve a keyframe by its decoding order
+*	@param i keyframe position
+*/
+const FrameIndexEntry &FrameIndex::keyFrameAt(const int i)
+{
+	return _entries[_keys[i]];
+}
@@ -0,0 +1,67 @@
+#ifndef FRAMEINDEX_H
+#define FRAMEINDEX_H
+
+#include <QString>
+#include <QAtomicInt>
+#include <vector>
+
+#include "ffmpeg.h"
+
+//! Single video packet of the index
+struct FrameIndexEntry {
+	qint64 pts;			//!< packet presentation timestamp (stream time base)
+	qint64 dts;			//!< packet decoding timestamp (stream time base)
+	qint64 pos;			//!< byte position of the packet in the file
+	qint32 flags;		//!< packet flags, AV_PKT_FLAG_KEY for keyframes
+	qint32 duration;	//!< packet duration (stream time base)
+};
+
+/*!
+*	@brief Class used to index the video packets of a file
+*
+*	Class used to index the video packets of a file.
+*	The index is built with a single demux-only pass (no decoding) and records,
+*	in decoding order, timestamps, byte position and keyframe flag of every packet
+*	of the video stream. It is stored in a sidecar file next to the video so that
+*	it's built only the first time the video is opened.
+*	QVideoDecoder uses it to seek directly to the keyframe that precedes the
+*	wanted frame instead of guessing a target timestamp.
+*	The packets are also the exact list of the frames, a Timeline built from
+*	them maps frame numbers to times.
+*/
+class FrameIndex
+{
+	std::vector<FrameIndexEntry>	_entries;	//!< all video packets
+	std::vector<int>				_keys;		//!< indexes of the keyframe packets
+	qint64							_fileSize;	//!< size of the indexed file
+	qint64							_fileTime;	//!< last modification of the indexed file
+	int								_stream;	//!< index of the indexed stream
+
+	//  Helpers
+	void	updateKeyFrames();
+	bool	readFileInfo(const QString &fileName);
+
+public:
+
+	FrameIndex();
+	~FrameIndex();
+
+	//  Index actions
+	bool	build(const QString &fileName, const int streamIndex, const QAtomicInt *abort = 0);
+	bool	load(const QString &fileName, const int streamIndex);
+	bool	save(const QString &fileName);
+	bool	loadOrBuild(const QString &fileName, const int streamIndex);
+	void	clear();
+
+	//  Getters
+	bool	isValid();
+	int		size();
+	int		numKeyFrames();
+	int		stream();
+	const FrameIndexEntry &at(const int i);
+	const FrameIndexEntry &keyFrameAt(const int i);
+
+	static QString sidecarPath(const QString &fileName);
+};
+
+#endif // FRAMEINDEX_H
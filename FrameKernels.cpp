@@ -0,0 +1,530 @@
+#include <vector>
+#include <algorithm>
+
+#include "FrameKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define FRAMEKERNELS_X86
+	#include <immintrin.h>
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+		#define TARGET_SSE2
+		#define TARGET_AVX2
+	#else
+		#define TARGET_SSE2 __attribute__((target("sse2")))
+		#define TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#endif
+
+// luma = (77 R + 150 G + 29 B) >> 8, the same in every version
+#define LUMA_R	77
+#define LUMA_G	150
+#define LUMA_B	29
+
+typedef void	(*lumaRowFn)(const uchar *src, const int width, uchar *dst);
+typedef quint64	(*sadFn)(const uchar *a, const uchar *b, const int size);
+
+//! Kernels of an instruction set
+struct KernelTable {
+	FrameKernels::Isa	isa;
+	lumaRowFn			lumaRow;
+	sadFn				sad;
+};
+
+
+/**************************************
+************    SCALAR    *************
+***************************************/
+
+static void lumaRowScalar(const uchar *src, const int width, uchar *dst)
+{
+	for (int x = 0; x < width; ++x, src += 4)
+		dst[x] = (LUMA_B * src[0] + LUMA_G * src[1] + LUMA_R * src[2]) >> 8;
+}
+
+static quint64 sadScalar(const uchar *a, const uchar *b, const int size)
+{
+	quint64 sum = 0;
+	for (int i = 0; i < size; ++i)
+		sum += (a[i] > b[i]) ? a[i] - b[i] : b[i] - a[i];
+	return sum;
+}
+
+
+#ifdef FRAMEKERNELS_X86
+
+/**************************************
+*************    SSE2    **************
+***************************************/
+
+/*! \brief luma of 4 RGB32 pixels
+*
+*	Channels are isolated in 32 bit lanes, products and sum fit in the low
+*	16 bits so 16 bit multiplications are enough.
+*	@return the lumas in the low byte of each 32 bit lane
+*/
+TARGET_SSE2 static inline __m128i luma4SSE2(const __m128i px)
+{
+	const __m128i mask = _mm_set1_epi32(0xff);
+	__m128i b = _mm_and_si128(px, mask);
+	__m128i g = _mm_and_si128(_mm_srli_epi32(px, 8), mask);
+	__m128i r = _mm_and_si128(_mm_srli_epi32(px, 16), mask);
+	__m128i y = _mm_add_epi16(
+		_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi32(LUMA_R)), _mm_mullo_epi16(g, _mm_set1_epi32(LUMA_G))),
+		_mm_mullo_epi16(b, _mm_set1_epi32(LUMA_B))
+	);
+	return _mm_srli_epi32(y, 8);
+}
+
+TARGET_SSE2 static void lumaRowSSE2(const uchar *src, const int width, uchar *dst)
+{
+	int x = 0;
+	for (; x + 16 <= width; x += 16, src += 64) {
+		__m128i y0 = luma4SSE2(_mm_loadu_si128((const __m128i *) src));
+		__m128i y1 = luma4SSE2(_mm_loadu_si128((const __m128i *) (src + 16)));
+		__m128i y2 = luma4SSE2(_mm_loadu_si128((const __m128i *) (src + 32)));
+		__m128i y3 = luma4SSE2(_mm_loadu_si128((const __m128i *) (src + 48)));
+		__m128i y = _mm_packus_epi16(_mm_packs_epi32(y0, y1), _mm_packs_epi32(y2, y3));
+		_mm_storeu_si128((__m128i *) (dst + x), y);
+	}
+	lumaRowScalar(src, width - x, dst + x);
+}
+
+TARGET_SSE2 static quint64 sadSSE2(const uchar *a, const uchar *b, const int size)
+{
+	__m128i acc = _mm_setzero_si128();
+	int i = 0;
+	for (; i + 16 <= size; i += 16) {
+		__m128i va = _mm_loadu_si128((const __m128i *) (a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i *) (b + i));
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+	}
+	quint64 sums[2];
+	_mm_storeu_si128((__m128i *) sums, acc);
+	return sums[0] + sums[1] + sadScalar(a + i, b + i, size - i);
+}
+
+
+/**************************************
+*************    AVX2    **************
+***************************************/
+
+TARGET_AVX2 static inline __m256i luma8AVX2(const __m256i px)
+{
+	const __m256i mask = _mm256_set1_epi32(0xff);
+	__m256i b = _mm256_and_si256(px, mask);
+	__m256i g = _mm256_and_si256(_mm256_srli_epi32(px, 8), mask);
+	__m256i r = _mm256_and_si256(_mm256_srli_epi32(px, 16), mask);
+	__m256i y = _mm256_add_epi16(
+		_mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi32(LUMA_R)), _mm256_mullo_epi16(g, _mm256_set1_epi32(LUMA_G))),
+		_mm256_mullo_epi16(b, _mm256_set1_epi32(LUMA_B))
+	);
+	return _mm256_srli_epi32(y, 8);
+}
+
+TARGET_AVX2 static void lumaRowAVX2(const uchar *src, const int width, uchar *dst)
+{
+	// packs work inside 128 bit lanes, the permutation restores the order
+	const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	int x = 0;
+	for (; x + 32 <= width; x += 32, src += 128) {
+		__m256i y0 = luma8AVX2(_mm256_loadu_si256((const __m256i *) src));
+		__m256i y1 = luma8AVX2(_mm256_loadu_si256((const __m256i *) (src + 32)));
+		__m256i y2 = luma8AVX2(_mm256_loadu_si256((const __m256i *) (src + 64)));
+		__m256i y3 = luma8AVX2(_mm256_loadu_si256((const __m256i *) (src + 96)));
+		__m256i y = _mm256_packus_epi16(_mm256_packs_epi32(y0, y1), _mm256_packs_epi32(y2, y3));
+		_mm256_storeu_si256((__m256i *) (dst + x), _mm256_permutevar8x32_epi32(y, order));
+	}
+	lumaRowSSE2(src, width - x, dst + x);
+}
+
+TARGET_AVX2 static quint64 sadAVX2(const uchar *a, const uchar *b, const int size)
+{
+	__m256i acc = _mm256_setzero_si256();
+	int i = 0;
+	for (; i + 32 <= size; i += 32) {
+		__m256i va = _mm256_loadu_si256((const __m256i *) (a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i *) (b + i));
+		acc = _mm256_add_epi64(acc, _mm256_sad_epu8(va, vb));
+	}
+	quint64 sums[4];
+	_mm256_storeu_si256((__m256i *) sums, acc);
+	return sums[0] + sums[1] + sums[2] + sums[3] + sadSSE2(a + i, b + i, size - i);
+}
+
+
+/**************************************
+*********    CPU DETECTION    *********
+***************************************/
+
+/*! \brief best instruction set of the CPU
+*
+*	Check the CPU, and the OS support of the AVX registers
+*/
+static FrameKernels::Isa detectIsa()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+		__cpuidex(info, 7, 0);
+		if (info[1] & (1 << 5))
+			return FrameKernels::IsaAVX2;
+	}
+	if (sse2)
+		return FrameKernels::IsaSSE2;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return FrameKernels::IsaAVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return FrameKernels::IsaSSE2;
+#endif
+	return FrameKernels::IsaScalar;
+}
+
+#else
+
+static FrameKernels::Isa detectIsa()
+{
+	return FrameKernels::IsaScalar;
+}
+
+#endif // FRAMEKERNELS_X86
+
+
+/**************************************
+***********    DISPATCH    ************
+***************************************/
+
+/*! \brief kernels of an instruction set
+*
+*	@param isa wanted instruction set, must be supported
+*	@return the table of the kernels
+*/
+static KernelTable makeTable(const FrameKernels::Isa isa)
+{
+	KernelTable t;
+	t.isa = FrameKernels::IsaScalar;
+	t.lumaRow = lumaRowScalar;
+	t.sad = sadScalar;
+#ifdef FRAMEKERNELS_X86
+	if (isa == FrameKernels::IsaAVX2) {
+		t.isa = isa;
+		t.lumaRow = lumaRowAVX2;
+		t.sad = sadAVX2;
+	}
+	else if (isa == FrameKernels::IsaSSE2) {
+		t.isa = isa;
+		t.lumaRow = lumaRowSSE2;
+		t.sad = sadSSE2;
+	}
+#endif
+	return t;
+}
+
+/*! \brief kernels in use
+*
+*	The kernels in use, the best ones the first time
+*/
+static KernelTable &table()
+{
+	static KernelTable t = makeTable(FrameKernels::getBestIsa());
+	return t;
+}
+
+/*! \brief Get the instruction set in use
+*
+*	Retrieve the instruction set used by the kernels
+*/
+FrameKernels::Isa FrameKernels::getIsa()
+{
+	return table().isa;
+}
+
+/*! \brief Get the best instruction set
+*
+*	Retrieve the best instruction set supported by the CPU
+*/
+FrameKernels::Isa FrameKernels::getBestIsa()
+{
+	static Isa best = detectIsa();
+	return best;
+}
+
+/*! \brief Force an instruction set
+*
+*	Force the instruction set used by the kernels, e.g. to compare them.
+*	Sets not supported by the CPU are replaced by the best one. Must not be
+*	called while kernels are running.
+*	@param isa instruction set
+*/
+void FrameKernels::setIsa(const Isa isa)
+{
+	table() = makeTable((isa > getBestIsa()) ? getBestIsa() : isa);
+}
+
+/*! \brief Get the name of an instruction set
+*
+*	@param isa instruction set
+*/
+const char *FrameKernels::getIsaName(const Isa isa)
+{
+	switch (isa) {
+		case IsaAVX2:	return "AVX2";
+		case IsaSSE2:	return "SSE2";
+		default:		return "scalar";
+	}
+}
+
+
+/**************************************
+************    KERNELS    ************
+***************************************/
+
+/*! \brief luma of a row
+*
+*	Compute the luma of a row of RGB32 pixels
+*	@param src first pixel
+*	@param width number of pixels
+*	@param dst where the lumas will be stored, width bytes
+*/
+void FrameKernels::lumaRow(const uchar *src, const int width, uchar *dst)
+{
+	table().lumaRow(src, width, dst);
+}
+
+/*! \brief sum of absolute differences
+*
+*	Sum of the absolute differences between two byte arrays, e.g. two luma
+*	thumbnails.
+*	@param a first array
+*	@param b second array
+*	@param size number of bytes
+*	@return the sum
+*/
+quint64 FrameKernels::sad(const uchar *a, const uchar *b, const int size)
+{
+	return table().sad(a, b, size);
+}
+
+/*! \brief per channel histograms
+*
+*	Compute the 256 bins histograms of R, G and B of an RGB32 image,
+*	considering one pixel every step in both directions. Bins can't be
+*	updated in parallel by SIMD registers: four partial histograms are used
+*	instead, so consecutive pixels don't wait for each other.
+*	@param src first pixel
+*	@param width image width
+*	@param height image height
+*	@param bytesPerLine size of a line
+*	@param step distance between two considered pixels
+*	@param hist where the R, G and B histograms will be stored, 3 * 256 bins
+*/
+void FrameKernels::histogramRGB32(
+	const uchar *src, const int width, const int height, const int bytesPerLine,
+	const int step, quint32 *hist
+)
+{
+	const int s = qMax(1, step);
+	std::vector<quint32> partial(4 * 3 * 256, 0);
+	quint32 *h[4] = { &partial[0], &partial[768], &partial[1536], &partial[2304] };
+
+	for (int y = 0; y < height; y += s) {
+		const uchar *p = src + y * bytesPerLine;
+		int x = 0, k = 0;
+		for (; x < width; x += s, k = (k + 1) & 3) {
+			const uchar *px = p + 4 * x;
+			++h[k][px[2]];
+			++h[k][256 + px[1]];
+			++h[k][512 + px[0]];
+		}
+	}
+
+	for (int i = 0; i < 768; ++i)
+		hist[i] = h[0][i] + h[1][i] + h[2][i] + h[3][i];
+}
+
+/*! \brief histogram of a plane
+*
+*	Compute the 256 bins histogram of an 8 bit plane, considering one value
+*	every step in both directions. Four partial histograms are used as in
+*	histogramRGB32().
+*	@param src first value
+*	@param width plane width
+*	@param height plane height
+*	@param linesize size of a line
+*	@param step distance between two considered values
+*	@param hist where the histogram will be stored, 256 bins
+*/
+void FrameKernels::histogramPlane(
+	const uchar *src, const int width, const int height, const int linesize,
+	const int step, quint32 *hist
+)
+{
+	const int s = qMax(1, step);
+	std::vector<quint32> partial(4 * 256, 0);
+	quint32 *h[4] = { &partial[0], &partial[256], &partial[512], &partial[768] };
+
+	for (int y = 0; y < height; y += s) {
+		const uchar *p = src + y * linesize;
+		int x = 0, k = 0;
+		for (; x < width; x += s, k = (k + 1) & 3)
+			++h[k][p[x]];
+	}
+
+	for (int i = 0; i < 256; ++i)
+		hist[i] = h[0][i] + h[1][i] + h[2][i] + h[3][i];
+}
+
+/*! \brief luma mean and variance of blocks
+*
+*	Split an RGB32 image into blocks and compute mean and variance of the
+*	luma of each of them. Only whole blocks are considered, there are
+*	(width / blockSize) * (height / blockSize) of them, row by row.
+*	@param src first pixel
+*	@param width image width
+*	@param height image height
+*	@param bytesPerLine size of a line
+*	@param blockSize side of a block
+*	@param mean where the means will be stored
+*	@param variance where the variances will be stored
+*/
+void FrameKernels::blockLumaStats(
+	const uchar *src, const int width, const int height, const int bytesPerLine,
+	const int blockSize, float *mean, float *variance
+)
+{
+	const int bw = width / blockSize, bh = height / blockSize;
+	const double n = (double) blockSize * blockSize;
+	if (bw <= 0 || bh <= 0)
+		return;
+
+	std::vector<uchar> row(bw * blockSize);
+	std::vector<quint32> sum(bw);
+	std::vector<quint64> sum2(bw);		// squares overflow 32 bits in blocks larger than 256x256
+	lumaRowFn lumaRowImpl = table().lumaRow;
+
+	for (int by = 0; by < bh; ++by) {
+		std::fill(sum.begin(), sum.end(), 0);
+		std::fill(sum2.begin(), sum2.end(), 0);
+
+		for (int y = by * blockSize; y < (by + 1) * blockSize; ++y) {
+			lumaRowImpl(src + y * bytesPerLine, bw * blockSize, &row[0]);
+			const uchar *l = &row[0];
+			for (int bx = 0; bx < bw; ++bx) {
+				quint32 s = 0, s2 = 0;
+				for (int x = 0; x < blockSize; ++x, ++l) {
+					s += *l;
+					s2 += *l * *l;
+				}
+				sum[bx] += s;
+				sum2[bx] += s2;
+			}
+		}
+
+		for (int bx = 0; bx < bw; ++bx) {
+			double m = sum[bx] / n;
+			mean[by * bw + bx] = m;
+			variance[by * bw + bx] = sum2[bx] / n - m * m;
+		}
+	}
+}
+
+/*! \brief box filter
+*
+*	Reduce an image to a thumbnail, each thumbnail pixel is the mean of the
+*	source values it covers. Source rows are turned into 8 bit values by
+*	the given function, or used as they are.
+*	@param src first row
+*	@param width values per row
+*	@param height number of rows
+*	@param bytesPerLine size of a row
+*	@param dst where the thumbnail will be stored
+*	@param dstWidth thumbnail width, not bigger than width
+*	@param dstHeight thumbnail height, not bigger than height
+*	@param convert row conversion, null for 8 bit rows
+*/
+static void boxFilter(
+	const uchar *src, const int width, const int height, const int bytesPerLine,
+	uchar *dst, const int dstWidth, const int dstHeight, lumaRowFn convert
+)
+{
+	if (dstWidth <= 0 || dstHeight <= 0 || dstWidth > width || dstHeight > height)
+		return;
+
+	// source columns covered by each thumbnail column
+	std::vector<int> xs(dstWidth + 1);
+	for (int dx = 0; dx <= dstWidth; ++dx)
+		xs[dx] = dx * width / dstWidth;
+
+	std::vector<uchar> buffer(convert ? width : 0);
+	std::vector<quint32> acc(dstWidth);
+
+	for (int dy = 0; dy < dstHeight; ++dy) {
+		const int y0 = dy * height / dstHeight, y1 = (dy + 1) * height / dstHeight;
+		std::fill(acc.begin(), acc.end(), 0);
+
+		for (int y = y0; y < y1; ++y) {
+			const uchar *row = src + y * bytesPerLine;
+			if (convert) {
+				convert(row, width, &buffer[0]);
+				row = &buffer[0];
+			}
+			for (int dx = 0; dx < dstWidth; ++dx) {
+				quint32 s = 0;
+				for (int x = xs[dx]; x < xs[dx + 1]; ++x)
+					s += row[x];
+				acc[dx] += s;
+			}
+		}
+
+		for (int dx = 0; dx < dstWidth; ++dx)
+			dst[dy * dstWidth + dx] = acc[dx] / ((xs[dx + 1] - xs[dx]) * (y1 - y0));
+	}
+}
+
+/*! \brief luma thumbnail
+*
+*	Reduce an RGB32 image to a luma thumbnail, each thumbnail pixel is the
+*	mean of the luma of the source pixels it covers.
+*	@param src first pixel
+*	@param width image width
+*	@param height image height
+*	@param bytesPerLine size of a line
+*	@param dst where the thumbnail will be stored, dstWidth * dstHeight bytes
+*	@param dstWidth thumbnail width, not bigger than width
+*	@param dstHeight thumbnail height, not bigger than height
+*/
+void FrameKernels::downsampleLuma(
+	const uchar *src, const int width, const int height, const int bytesPerLine,
+	uchar *dst, const int dstWidth, const int dstHeight
+)
+{
+	boxFilter(src, width, height, bytesPerLine, dst, dstWidth, dstHeight, table().lumaRow);
+}
+
+/*! \brief plane thumbnail
+*
+*	Reduce an 8 bit plane (e.g. the luma plane of a decoded frame) to a
+*	thumbnail, each thumbnail pixel is the mean of the values it covers.
+*	@param src first value
+*	@param width plane width
+*	@param height plane height
+*	@param linesize size of a line
+*	@param dst where the thumbnail will be stored, dstWidth * dstHeight bytes
+*	@param dstWidth thumbnail width, not bigger than width
+*	@param dstHeight thumbnail height, not bigger than height
+*/
+void FrameKernels::downsamplePlane(
+	const uchar *src, const int width, const int height, const int linesize,
+	uchar *dst, const int dstWidth, const int dstHeight
+)
+{
+	boxFilter(src, width, height, linesize, dst, dstWidth, dstHeight, 0);
+}
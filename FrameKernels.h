@@ -0,0 +1,62 @@
+#ifndef FRAMEKERNELS_H
+#define FRAMEKERNELS_H
+
+#include <QtGlobal>
+
+/*!
+*	@brief Class used to compute low level measures on decoded frames
+*
+*	Class used to compute low level measures on decoded frames, the hot
+*	loops of the shot detection.
+*	Frames are RGB32 images as produced by QVideoDecoder (B, G, R, X bytes in
+*	memory) or 8 bit planes of the decoded frames. lumaRow() and sad() have
+*	a scalar version and, on x86, SSE2 and AVX2 ones; the best version
+*	supported by the CPU is chosen at runtime the first time a kernel is
+*	used. The histograms and the accumulations of blockLumaStats() and of
+*	the thumbnails are scalar, the last two convert RGB32 rows with the
+*	lumaRow() in use. All versions give exactly the same results, see
+*	FrameKernelsTest.
+*/
+class FrameKernels
+{
+public:
+
+	//! Instruction set used by the kernels
+	enum Isa {
+		IsaScalar,
+		IsaSSE2,
+		IsaAVX2
+	};
+
+	//  Dispatch
+	static Isa		getIsa();
+	static Isa		getBestIsa();
+	static void		setIsa(const Isa isa);
+	static const char *getIsaName(const Isa isa);
+
+	//  Kernels
+	static void		lumaRow(const uchar *src, const int width, uchar *dst);
+	static quint64	sad(const uchar *a, const uchar *b, const int size);
+	static void		histogramRGB32(
+		const uchar *src, const int width, const int height, const int bytesPerLine,
+		const int step, quint32 *hist
+	);
+	static void		histogramPlane(
+		const uchar *src, const int width, const int height, const int linesize,
+		const int step, quint32 *hist
+	);
+	static void		blockLumaStats(
+		const uchar *src, const int width, const int height, const int bytesPerLine,
+		const int blockSize, float *mean, float *variance
+	);
+	static void		downsampleLuma(
+		const uchar *src, const int width, const int height, const int bytesPerLine,
+		uchar *dst, const int dstWidth, const int dstHeight
+	);
+	static void		downsamplePlane(
+		const uchar *src, const int width, const int height, const int linesize,
+		uchar *dst, const int dstWidth, const int dstHeight
+	);
+};
+
+#endif // FRAMEKERNELS_H
@@ -0,0 +1,163 @@
+/*
+   ShotManager (2015 x64)
+		Luca Gallinari
+		Dario Stabili
+		Marco Ravazzini
+
+	Check of the FrameKernels: runs every kernel with each instruction set
+	supported by the CPU on random images and compares the results with the
+	scalar ones, which must be exactly the same.
+
+*/
+
+#include <QtGlobal>
+#include <vector>
+#include <random>
+#include <cstdio>
+#include <algorithm>
+
+#include "FrameKernels.h"
+
+#define TEST_SEED		4242	// same images at every run
+#define TEST_HEIGHT		67		// rows of the test images
+#define TEST_BLOCK		8		// side of the blocks of blockLumaStats
+#define TEST_THUMB_W	21		// size of the thumbnails, not dividing the widths
+#define TEST_THUMB_H	13
+#define TEST_LARGE_BLOCK	400		// side of the block of checkLargeBlock
+
+//! Results of all the kernels on an image
+struct KernelResults {
+	std::vector<uchar>		luma;
+	quint64					sad;
+	std::vector<quint32>	histRGB;
+	std::vector<quint32>	histPlane;
+	std::vector<float>		mean;
+	std::vector<float>		variance;
+	std::vector<uchar>		thumbLuma;
+	std::vector<uchar>		thumbPlane;
+
+	bool operator==(const KernelResults &o) const {
+		return
+			luma == o.luma && sad == o.sad && histRGB == o.histRGB && histPlane == o.histPlane &&
+			mean == o.mean && variance == o.variance &&
+			thumbLuma == o.thumbLuma && thumbPlane == o.thumbPlane;
+	}
+};
+
+/*! \brief Run all the kernels
+*
+*	Run all the kernels, with the instruction set in use, on an RGB32 image
+*	and an 8 bit plane of the same size
+*/
+static KernelResults runKernels(
+	const uchar *rgb, const int width, const int height, const int bytesPerLine,
+	const uchar *plane, const int linesize
+)
+{
+	KernelResults r;
+
+	r.luma.resize(width);
+	FrameKernels::lumaRow(rgb, width, &r.luma[0]);
+
+	// the first rows against the last ones, the size isn't a multiple of the registers
+	r.sad = FrameKernels::sad(plane, plane + (height / 2) * linesize, (height / 2) * linesize - 3);
+
+	r.histRGB.resize(3 * 256);
+	FrameKernels::histogramRGB32(rgb, width, height, bytesPerLine, 3, &r.histRGB[0]);
+	r.histPlane.resize(256);
+	FrameKernels::histogramPlane(plane, width, height, linesize, 1, &r.histPlane[0]);
+
+	const int blocks = (width / TEST_BLOCK) * (height / TEST_BLOCK);
+	r.mean.resize(blocks);
+	r.variance.resize(blocks);
+	FrameKernels::blockLumaStats(rgb, width, height, bytesPerLine, TEST_BLOCK, &r.mean[0], &r.variance[0]);
+
+	r.thumbLuma.resize(TEST_THUMB_W * TEST_THUMB_H);
+	FrameKernels::downsampleLuma(rgb, width, height, bytesPerLine, &r.thumbLuma[0], TEST_THUMB_W, TEST_THUMB_H);
+	r.thumbPlane.resize(TEST_THUMB_W * TEST_THUMB_H);
+	FrameKernels::downsamplePlane(plane, width, height, linesize, &r.thumbPlane[0], TEST_THUMB_W, TEST_THUMB_H);
+	return r;
+}
+
+/*! \brief Check an image size
+*
+*	Check all the instruction sets on random images of the given width. The
+*	images start one byte after an aligned address, the SIMD versions must
+*	not rely on the alignment.
+*	@return the results are the same or not
+*/
+static bool checkWidth(std::mt19937 &random, const int width)
+{
+	const int bytesPerLine = 4 * width + 12, linesize = width + 5;
+	std::vector<uchar> rgb(bytesPerLine * TEST_HEIGHT + 1), plane(linesize * TEST_HEIGHT + 1);
+	std::uniform_int_distribution<int> byte(0, 255);
+	for (uchar &v : rgb)
+		v = byte(random);
+	for (uchar &v : plane)
+		v = byte(random);
+
+	FrameKernels::setIsa(FrameKernels::IsaScalar);
+	const KernelResults ref = runKernels(&rgb[1], width, TEST_HEIGHT, bytesPerLine, &plane[1], linesize);
+
+	// the scalar luma must follow its formula
+	bool ok = true;
+	for (int x = 0; x < width; ++x) {
+		const uchar *px = &rgb[1 + 4 * x];
+		ok = ok && ref.luma[x] == ((29 * px[0] + 150 * px[1] + 77 * px[2]) >> 8);
+	}
+	if (!ok)
+		printf("width %3d  scalar luma  FAILED\n", width);
+
+	for (int isa = FrameKernels::IsaSSE2; isa <= FrameKernels::getBestIsa(); ++isa) {
+		FrameKernels::setIsa((FrameKernels::Isa) isa);
+		bool same = runKernels(&rgb[1], width, TEST_HEIGHT, bytesPerLine, &plane[1], linesize) == ref;
+		if (!same)
+			printf("width %3d  %-6s  FAILED\n", width, FrameKernels::getIsaName((FrameKernels::Isa) isa));
+		ok = ok && same;
+	}
+	return ok;
+}
+
+/*! \brief Check a large block
+*
+*	Check blockLumaStats on a single large block of black and white
+*	columns, whose sum of squares doesn't fit in 32 bits.
+*	@return mean and variance are right or not
+*/
+static bool checkLargeBlock()
+{
+	const int side = TEST_LARGE_BLOCK;
+	std::vector<uchar> rgb(4 * side * side);
+	for (int i = 0; i < side * side; ++i)
+		std::fill(&rgb[4 * i], &rgb[4 * i] + 4, (i % 2) ? 255 : 0);
+
+	float mean = 0, variance = 0;
+	FrameKernels::setIsa(FrameKernels::IsaScalar);
+	FrameKernels::blockLumaStats(&rgb[0], side, side, 4 * side, side, &mean, &variance);
+
+	// half the luma are 0 and half 255
+	const bool ok = qAbs(mean - 127.5f) < 0.01f && qAbs(variance - 127.5f * 127.5f) < 1;
+	if (!ok)
+		printf("block %d  mean %.2f, variance %.2f  FAILED\n", side, mean, variance);
+	return ok;
+}
+
+int main()
+{
+	printf("Best instruction set: %s\n", FrameKernels::getIsaName(FrameKernels::getBestIsa()));
+
+	// widths around the register sizes, to cover the tails of the loops
+	const int widths[] = { 24, 31, 32, 33, 63, 64, 65, 127, 160, 333 };
+	std::mt19937 random(TEST_SEED);
+	int failed = 0;
+	for (int w : widths) {
+		if (!checkWidth(random, w))
+			++failed;
+	}
+
+	if (!checkLargeBlock())
+		++failed;
+
+	printf("%s: %d of %d sizes differ\n", failed ? "FAILED" : "OK", failed, (int) (sizeof(widths) / sizeof(widths[0])) + 1);
+	return failed ? 1 : 0;
+}
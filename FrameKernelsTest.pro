@@ -0,0 +1,15 @@
+# -------------------------------------------------
+# Check of the SIMD frame kernels against the scalar ones
+# -------------------------------------------------
+QT       += core
+QT       -= gui
+CONFIG   += c++11 console
+CONFIG   -= app_bundle
+
+TARGET = FrameKernelsTest
+TEMPLATE = app
+
+SOURCES +=  FrameKernelsTest.cpp \
+            FrameKernels.cpp
+
+HEADERS +=  FrameKernels.h
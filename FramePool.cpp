@@ -0,0 +1,154 @@
+
+#include "FramePool.h"
+
+/*! \brief Create an empty pool
+*
+*	Create an empty pool, setGeometry() must be called before acquire()
+*/
+FramePool::FramePool()
+{
+	_width = _height = _bytesPerLine = 0;
+}
+
+/*! \brief Destroyer
+*
+*	Free the buffers not lent. Lent buffers keep the pool alive, so there
+*	are none when this is called.
+*/
+FramePool::~FramePool()
+{
+	for (Buffer *b : _free)
+		freeBuffer(b);
+	_free.clear();
+}
+
+
+/**************************************
+**********    POOL ACTIONS    *********
+***************************************/
+
+/*! \brief set the size of the images
+*
+*	Set the size of the images lent from now on. Free buffers of the old size
+*	are released, lent ones will be released when they come back.
+*	@param width image width
+*	@param height image height
+*/
+void FramePool::setGeometry(const int width, const int height)
+{
+	QMutexLocker locker(&_mutex);
+
+	int bytesPerLine = (width * 4 + FRAMEPOOL_ALIGNMENT - 1) & ~(FRAMEPOOL_ALIGNMENT - 1);
+	if (width == _width && height == _height && bytesPerLine == _bytesPerLine)
+		return;
+
+	_width = width;
+	_height = height;
+	_bytesPerLine = bytesPerLine;
+
+	for (Buffer *b : _free)
+		freeBuffer(b);
+	_free.clear();
+}
+
+/*! \brief lend an image
+*
+*	Lend an RGB32 image of the current size, its memory is reused from an
+*	image destroyed before when possible. Its content is undefined.
+*	@return the image, null if the geometry is not valid or memory is over
+*/
+QImage FramePool::acquire()
+{
+	Buffer *b = 0;
+	int width, height, bytesPerLine;
+	{
+		QMutexLocker locker(&_mutex);
+		width = _width;
+		height = _height;
+		bytesPerLine = _bytesPerLine;
+		if (!_free.empty()) {
+			b = _free.back();
+			_free.pop_back();
+		}
+	}
+
+	if (width <= 0 || height <= 0)
+		return QImage();
+
+	if (!b) {
+		b = new Buffer;
+		b->bytes = bytesPerLine * height;
+		b->data = (uchar *) qMallocAligned(b->bytes, FRAMEPOOL_ALIGNMENT);
+		if (!b->data) {
+			delete b;
+			return QImage();
+		}
+	}
+	b->pool = sharedFromThis();
+
+	return QImage(b->data, width, height, bytesPerLine, QImage::Format_RGB32, recycle, b);
+}
+
+
+/**************************************
+************    HELPERS    ************
+***************************************/
+
+/*! \brief take back a buffer
+*
+*	Keep a buffer that is not used anymore for the next images, free it if
+*	it has the wrong size or there are enough free buffers.
+*	@param b buffer
+*/
+void FramePool::giveBack(Buffer *b)
+{
+	{
+		QMutexLocker locker(&_mutex);
+		if (b->bytes == _bytesPerLine * _height && _free.size() < FRAMEPOOL_MAX_FREE) {
+			_free.push_back(b);
+			return;
+		}
+	}
+	freeBuffer(b);
+}
+
+/*! \brief QImage cleanup function
+*
+*	Called by QImage when the last copy of a lent image is destroyed.
+*	@param info the lent buffer
+*/
+void FramePool::recycle(void *info)
+{
+	Buffer *b = (Buffer *) info;
+
+	// the buffer must not keep the pool alive while it is free, the pool may
+	// be destroyed when this function ends
+	QSharedPointer<FramePool> pool = b->pool;
+	b->pool.clear();
+	pool->giveBack(b);
+}
+
+/*! \brief free a buffer
+*
+*	Free the memory of a buffer
+*	@param b buffer
+*/
+void FramePool::freeBuffer(Buffer *b)
+{
+	qFreeAligned(b->data);
+	delete b;
+}
+
+
+/**************************************
+*********        GETTERS      *********
+***************************************/
+
+/*! \brief Get line size
+*
+*	Retrieve the aligned size in bytes of a line of the images
+*/
+int FramePool::getBytesPerLine()
+{
+	return _bytesPerLine;
+}
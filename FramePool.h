@@ -0,0 +1,56 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QImage>
+#include <QMutex>
+#include <QSharedPointer>
+#include <vector>
+
+#define FRAMEPOOL_ALIGNMENT	64	// bytes, enough for any SIMD path of swscale
+#define FRAMEPOOL_MAX_FREE	8	// free buffers kept for reuse
+
+/*!
+*	@brief Class used to recycle the memory of the decoded images
+*
+*	Class used to recycle the memory of the decoded images.
+*	It lends aligned RGB32 buffers already wrapped by a QImage, so that
+*	swscale can write the converted frame directly into the image. When the
+*	last Frame sharing the image is destroyed the buffer goes back to the
+*	pool instead of being freed.
+*	Buffers can come back from any thread and after the owner of the pool is
+*	gone: every lent buffer keeps the pool alive.
+*/
+class FramePool : public QEnableSharedFromThis<FramePool>
+{
+	//! Buffer lent to a QImage
+	struct Buffer {
+		QSharedPointer<FramePool>	pool;	//!< set only while lent
+		uchar						*data;
+		int							bytes;
+	};
+
+	QMutex					_mutex;		//!< buffers come back from any thread
+	std::vector<Buffer *>	_free;		//!< buffers ready to be lent
+	int						_width;
+	int						_height;
+	int						_bytesPerLine;	//!< aligned line size
+
+	//  Helpers
+	void giveBack(Buffer *b);
+	static void recycle(void *info);
+	static void freeBuffer(Buffer *b);
+
+public:
+
+	FramePool();
+	~FramePool();
+
+	//  Pool actions
+	void	setGeometry(const int width, const int height);
+	QImage	acquire();
+
+	//  Getters
+	int		getBytesPerLine();
+};
+
+#endif // FRAMEPOOL_H
@@ -0,0 +1,251 @@
+
+#include "FramePrefetcher.h"
+
+/*! \brief Create the prefetcher
+*
+*	Create the prefetcher, the thread is started when a video is opened
+*
+*	@param capacity max number of decoded frames kept
+*	@param decoders decoders of the video, shared with the ImagesBuffer
+*/
+FramePrefetcher::FramePrefetcher(const unsigned capacity, DecoderPool *decoders) :
+	_decoders(decoders), _capacity(capacity)
+{
+	_numFrames = 0;
+	_pending = false;
+	_reqStart = _reqCount = 0;
+	_workNext = _workEnd = -1;
+	_abort = false;
+	_quit = false;
+}
+
+/*! \brief Destroyer
+*
+*	Stop the worker and wait for it
+*/
+FramePrefetcher::~FramePrefetcher()
+{
+	_mutex.lock();
+	_quit = true;
+	_abort = true;
+	_requestCond.wakeAll();
+	_mutex.unlock();
+
+	wait();
+}
+
+/*! \brief Worker loop
+*
+*	Wait for a request and decode its frames one by one, publishing each of
+*	them as soon as it is ready. The request is abandoned when a new one comes.
+*/
+void FramePrefetcher::run()
+{
+	forever {
+		_mutex.lock();
+		while (!_pending && !_quit)
+			_requestCond.wait(&_mutex);
+		if (_quit) {
+			_mutex.unlock();
+			return;
+		}
+
+		qint64 start = _reqStart;
+		qint64 count = _reqCount;
+		_pending = false;
+		_abort = false;
+
+		evictFarFrames(start, count);
+
+		// skip frames already decoded
+		while (count > 0 && _ready.contains(start)) {
+			++start;
+			--count;
+		}
+		_workNext = start;
+		_workEnd = start + count;
+		_mutex.unlock();
+
+		QVideoDecoder *decoder = (count > 0) ? _decoders->acquire(start) : 0;
+		bool ok = decoder && decoder->seekFrame(start);
+		for (qint64 num = start; ; ) {
+			Frame f;
+			ok = ok && decoder->getFrame(f.img, &f.num, &f.time);
+
+			// publish, numbered by the decoder: a frame it skipped is left to
+			// the caller, one it gives again is dropped
+			_mutex.lock();
+			if (_abort) {
+				ok = false;
+			}
+			else if (ok && f.num >= num) {
+				if (f.num < _workEnd)
+					_ready.insert(f.num, f);
+				num = f.num + 1;
+				_workNext = num;
+			}
+			// the end can be moved forward by prefetch() meanwhile: it is checked
+			// and the request closed under the same lock, so an extension is
+			// either decoded or queued again by prefetch()
+			if (num >= _workEnd)
+				ok = false;
+			if (!ok)
+				_workNext = _workEnd = -1;
+			_frameCond.wakeAll();
+			_mutex.unlock();
+
+			if (!ok)
+				break;
+			ok = decoder->seekNextFrame();
+		}
+		if (decoder)
+			_decoders->release(decoder);
+	}
+}
+
+
+/**************************************
+*********    VIDEO ACTIONS    *********
+***************************************/
+
+/*! \brief set the video.
+*
+*   Set the video the pool decoders have been opened on and start the worker
+*	if needed.
+*	@param numFrames number of frames of the video
+*/
+void FramePrefetcher::setVideo(const qint64 numFrames)
+{
+	clear();
+
+	_mutex.lock();
+	_numFrames = numFrames;
+	_mutex.unlock();
+
+	if (!isRunning())
+		start(QThread::LowPriority);
+}
+
+
+/*! \brief change the capacity
+*
+*   Change the max number of decoded frames kept.
+*	@param capacity max number of decoded frames
+*/
+void FramePrefetcher::setCapacity(const unsigned capacity)
+{
+	QMutexLocker locker(&_mutex);
+	_capacity = capacity;
+}
+
+
+/**************************************
+*********    FRAME ACTIONS    *********
+***************************************/
+
+/*! \brief request the decoding of a range of frames
+*
+*	Request the decoding of a range of frames, the range is clipped to the
+*	video length. The request in progress, if any, is abandoned unless the
+*	new range just continues it.
+*	@param start first frame number
+*	@param count number of frames
+*/
+void FramePrefetcher::prefetch(qint64 start, qint64 count)
+{
+	QMutexLocker locker(&_mutex);
+
+	if (start < 0) {
+		count += start;
+		start = 0;
+	}
+	if (start + count > _numFrames)
+		count = _numFrames - start;
+	if (count <= 0)
+		return;
+
+	// the worker is decoding sequentially towards this range: just extend
+	// the request in progress instead of seeking again
+	if (!_pending && _workEnd != -1 && start <= _workEnd && start + count > _workNext) {
+		bool contiguous = true;
+		for (qint64 num = start; contiguous && num < _workNext; ++num)
+			contiguous = _ready.contains(num);
+		if (contiguous) {
+			if (start + count > _workEnd)
+				_workEnd = start + count;
+			evictFarFrames(start, count);
+			return;
+		}
+	}
+
+	_reqStart = start;
+	_reqCount = count;
+	_pending = true;
+	_abort = true;
+	_requestCond.wakeOne();
+}
+
+/*! \brief retrieve a prefetched frame
+*
+*	Retrieve a prefetched frame. If the frame is not ready yet but the worker
+*	is going to publish it with the request in progress, wait for it.
+*	@param num frame number
+*	@param f where the frame will be stored, it shares the prefetched image
+*	@return the frame was available or not
+*/
+bool FramePrefetcher::takeFrame(const qint64 num, Frame &f)
+{
+	QMutexLocker locker(&_mutex);
+
+	forever {
+		QMap<qint64, Frame>::const_iterator it = _ready.constFind(num);
+		if (it != _ready.constEnd()) {
+			f = it.value();
+			return true;
+		}
+		// not going to be decoded soon, the caller has to decode it
+		if (_pending || num < _workNext || num >= _workEnd)
+			return false;
+		_frameCond.wait(&_mutex);
+	}
+}
+
+/*! \brief clear the prefetcher
+*
+*	Abandon the request in progress and drop all decoded frames
+*/
+void FramePrefetcher::clear()
+{
+	QMutexLocker locker(&_mutex);
+	_pending = false;
+	_abort = true;
+	_ready.clear();
+}
+
+
+/**************************************
+************    HELPERS    ************
+***************************************/
+
+/*! \brief drop frames far from a range
+*
+*	Drop the decoded frames that are far from the given range so that the
+*	number of ready frames stays under the capacity. Must be called with the
+*	mutex locked.
+*	@param start first frame number of the range
+*	@param count number of frames of the range
+*/
+void FramePrefetcher::evictFarFrames(const qint64 start, const qint64 count)
+{
+	qint64 margin = ((qint64) _capacity - count) / 2;
+	if (margin < 0)
+		margin = 0;
+
+	QMap<qint64, Frame>::iterator it = _ready.begin();
+	while (it != _ready.end()) {
+		if (it.key() < start - margin || it.key() >= start + count + margin)
+			it = _ready.erase(it);
+		else
+			++it;
+	}
+}
@@ -0,0 +1,66 @@
+#ifndef FRAMEPREFETCHER_H
+#define FRAMEPREFETCHER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QMap>
+
+#include "DecoderPool.h"
+#include "Frame.h"
+
+/*!
+*	@brief Thread used to decode frames before they are requested
+*
+*	Thread used to decode frames before they are requested.
+*	It borrows a decoder of the DecoderPool for each request, so it never moves
+*	the position of the one used by the ImagesBuffer and both decode in
+*	parallel. The ImagesBuffer asks it to decode a range of frames
+*	in the direction of navigation, decoded frames are published as soon as they
+*	are ready and can be taken by the GUI thread. A new request cancels the one
+*	in progress.
+*	Frames are published as Frame handles, taking one only shares its image.
+*/
+class FramePrefetcher : public QThread
+{
+	DecoderPool		*_decoders;		//!< decoders of the video, shared
+
+	QMutex			_mutex;			//!< protects all the variables below
+	QWaitCondition	_requestCond;	//!< a new request arrived
+	QWaitCondition	_frameCond;		//!< a new frame has been published
+
+	QMap<qint64, Frame>	_ready;			//!< decoded frames by number
+	unsigned	_capacity;			//!< max number of ready frames
+	qint64		_numFrames;
+
+	bool		_pending;			//!< a request is waiting to be served
+	qint64		_reqStart;			//!< first frame of the pending request
+	qint64		_reqCount;			//!< num frames of the pending request
+	qint64		_workNext;			//!< next frame the worker will publish
+	qint64		_workEnd;			//!< end (excluded) of the request in progress
+	bool		_abort;				//!< stop the request in progress
+	bool		_quit;				//!< stop the thread
+
+	//  Helpers
+	void evictFarFrames(const qint64 start, const qint64 count);
+
+protected:
+	void run();
+
+public:
+
+	FramePrefetcher(const unsigned capacity, DecoderPool *decoders);
+	~FramePrefetcher();
+
+	//  Video actions
+	void setVideo(const qint64 numFrames);
+	void setCapacity(const unsigned capacity);
+
+	//  Frame actions
+	void prefetch(qint64 start, qint64 count);
+	bool takeFrame(const qint64 num, Frame &f);
+	void clear();
+
+};
+
+#endif // FRAMEPREFETCHER_H
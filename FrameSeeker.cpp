@@ -0,0 +1,190 @@
+#include "FrameSeeker.h"
+
+/*! \brief Create the seeker
+*
+*	Create the seeker and start its thread
+*
+*	@param decoders decoders of the video, shared with the ImagesBuffer
+*/
+FrameSeeker::FrameSeeker(DecoderPool *decoders) : _decoders(decoders)
+{
+	_ticket = 0;
+	_target = -1;
+	_pending = false;
+	_hasResult = false;
+	_quit = false;
+	start();
+}
+
+/*! \brief Destroyer
+*
+*	Stop the worker and wait for it
+*/
+FrameSeeker::~FrameSeeker()
+{
+	_mutex.lock();
+	_quit = true;
+	++_ticket;
+	_requestCond.wakeAll();
+	_mutex.unlock();
+
+	wait();
+}
+
+/*! \brief Worker loop
+*
+*	Wait for a request and decode its frame, publishing the keyframe of its
+*	GOP first when the decoder has to seek. The request is abandoned as soon
+*	as a newer one comes.
+*/
+void FrameSeeker::run()
+{
+	forever {
+		_mutex.lock();
+		while (!_pending && !_quit)
+			_requestCond.wait(&_mutex);
+		if (_quit) {
+			_mutex.unlock();
+			return;
+		}
+
+		quint64 ticket = _ticket;
+		qint64 num = _target;
+		_pending = false;
+		_mutex.unlock();
+
+		QVideoDecoder *decoder = _decoders->acquire(num);
+		bool ok = decoder != 0;
+		bool cancelled = false;
+		SeekResult r;
+
+		// far from the decoder position: the keyframe is ready long before
+		// the frame, show it meanwhile
+		if (ok && decoder->getForwardDistance(num) < 0) {
+			qint64 key = decoder->getKeyFrameNumber(num);
+			if (key >= 0 && key < num) {
+				ok = decoder->seekFrame(key);
+				if (ok && decoder->getFrame(r.img, 0, &r.time)) {
+					r.num = key;
+					r.state = SeekPreview;
+					publish(ticket, r);
+				}
+			}
+		}
+
+		// decode forward one frame at a time, so a newer request stops it
+		if (ok && decoder->getForwardDistance(num) >= 0) {
+			for (qint64 f = decoder->getIdealFrameNumber() + 1; ok && f <= num; ++f) {
+				if ((cancelled = isCancelled(ticket)))
+					break;
+				ok = decoder->seekFrame(f);
+			}
+		}
+
+		// no packets index: a single seek, it can't be stopped
+		if (ok && !cancelled && decoder->getIdealFrameNumber() != num)
+			ok = decoder->seekFrame(num);
+
+		if (!cancelled) {
+			r.img = QImage();
+			r.num = num;
+			r.state = (ok && decoder->getFrame(r.img, 0, &r.time)) ? SeekExact : SeekFailed;
+			publish(ticket, r);
+		}
+		if (decoder)
+			_decoders->release(decoder);
+	}
+}
+
+
+/**************************************
+*********    SEEK ACTIONS    **********
+***************************************/
+
+/*! \brief request a frame
+*
+*	Ask to decode a frame, the request in progress (if any) is cancelled.
+*	@param num frame number
+*	@return ticket of the request, to be given to take()
+*/
+quint64 FrameSeeker::request(const qint64 num)
+{
+	QMutexLocker locker(&_mutex);
+
+	_target = num;
+	_pending = true;
+	_hasResult = false;
+	_requestCond.wakeOne();
+	return ++_ticket;
+}
+
+/*! \brief cancel the requests
+*
+*	Cancel the request in progress, if any, without asking for a new one.
+*	@return ticket that no result will ever match, e.g. for a frame that
+*		didn't need to be decoded
+*/
+quint64 FrameSeeker::cancel()
+{
+	QMutexLocker locker(&_mutex);
+
+	_pending = false;
+	_hasResult = false;
+	return ++_ticket;
+}
+
+/*! \brief take the result of a request
+*
+*	Take the last result of a request that has not been taken yet, the
+*	preview may be skipped when the exact frame is ready first.
+*	@param ticket ticket given by request()
+*	@param r where the result will be stored
+*	@return state of the request
+*/
+SeekState FrameSeeker::take(const quint64 ticket, SeekResult &r)
+{
+	QMutexLocker locker(&_mutex);
+
+	if (ticket != _ticket)
+		return SeekCancelled;
+	if (!_hasResult)
+		return SeekPending;
+
+	r = _result;
+	_result.img = QImage();
+	_hasResult = false;
+	return r.state;
+}
+
+
+/**************************************
+************    HELPERS    ************
+***************************************/
+
+/*! \brief the request has been cancelled?
+*
+*	Checks if a newer request has been made
+*	@param ticket ticket of the request
+*/
+bool FrameSeeker::isCancelled(const quint64 ticket)
+{
+	QMutexLocker locker(&_mutex);
+	return ticket != _ticket;
+}
+
+/*! \brief publish a result
+*
+*	Make a result available to take(), unless its request has been cancelled
+*	@param ticket ticket of the request
+*	@param r the result, its image is moved
+*/
+void FrameSeeker::publish(const quint64 ticket, SeekResult &r)
+{
+	QMutexLocker locker(&_mutex);
+
+	if (ticket != _ticket)
+		return;
+	_result = r;
+	r.img = QImage();
+	_hasResult = true;
+}
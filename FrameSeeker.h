@@ -0,0 +1,73 @@
+#ifndef FRAMESEEKER_H
+#define FRAMESEEKER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "DecoderPool.h"
+#include "Frame.h"
+
+#define SEEKER_POLL_MS	10	// wait between two checks of a seek in progress
+
+//! State of an asynchronous seek
+enum SeekState {
+	SeekPending,	//!< nothing new since the last check
+	SeekPreview,	//!< the keyframe of the requested frame is ready
+	SeekExact,		//!< the requested frame is ready
+	SeekFailed,		//!< the requested frame could not be decoded
+	SeekCancelled	//!< a newer seek has been requested
+};
+
+//! Frame decoded by the seeker
+struct SeekResult : Frame {
+	SeekState state = SeekPending;
+};
+
+/*!
+*	@brief Thread used to seek without blocking the user interface
+*
+*	Thread used to seek without blocking the user interface (e.g. while
+*	dragging the video slider).
+*	Every request gets a ticket and cancels the ones before it: the worker
+*	checks for a newer request after every decoded frame, so it never decodes
+*	a long GOP for a frame nobody wants anymore. When the frame is far from
+*	the position of the decoder, the keyframe of its GOP is published first
+*	as a preview, then the frame itself when the decoding reaches it.
+*	Results are polled by the GUI thread with take(); like the prefetcher,
+*	it borrows a decoder of the DecoderPool for each request and publishes
+*	Frame handles.
+*/
+class FrameSeeker : public QThread
+{
+	DecoderPool		*_decoders;		//!< decoders of the video, shared
+
+	QMutex			_mutex;			//!< protects all the variables below
+	QWaitCondition	_requestCond;	//!< a new request arrived
+
+	quint64			_ticket;		//!< ticket of the latest request
+	qint64			_target;		//!< frame of the latest request
+	bool			_pending;		//!< the latest request is not started yet
+	SeekResult		_result;		//!< last result of the latest request
+	bool			_hasResult;		//!< the result has not been taken yet
+	bool			_quit;			//!< stop the thread
+
+	//  Helpers
+	bool	isCancelled(const quint64 ticket);
+	void	publish(const quint64 ticket, SeekResult &r);
+
+protected:
+	void run();
+
+public:
+
+	FrameSeeker(DecoderPool *decoders);
+	~FrameSeeker();
+
+	//  Seek actions
+	quint64		request(const qint64 num);
+	quint64		cancel();
+	SeekState	take(const quint64 ticket, SeekResult &r);
+};
+
+#endif // FRAMESEEKER_H
@@ -1,8 +1,8 @@
 
 #include <QMessageBox>
-#include <QPainter>
 
 #include "ImagesBuffer.h"
+#include "Profiler.h"
 
 /*! \brief Create and setup the images buffer
 *
@@ -10,12 +10,24 @@
 *
 *	@param maxsize max size of the buffer
 */
-ImagesBuffer::ImagesBuffer(const unsigned maxsize = 1) : _maxsize(maxsize)
+ImagesBuffer::ImagesBuffer(const unsigned maxsize = 1) :
+	_cache(FRAMECACHE_DEFAULT_BUDGET), _maxsize(maxsize), _thumbCache(THUMBCACHE_DEFAULT_BUDGET)
 {
 	if (maxsize <= 0) {
 		_maxsize = 1;
 	}
 	_mid = (_maxsize - 1) / 2;
+	_prefetcher = new FramePrefetcher(2 * _maxsize, &_decoders);
+	_seeker = new FrameSeeker(&_decoders);
+	_seekTicket = 0;
+	_filmstripEnabled = true;
+	_thumbReady = false;
+	_thumbNext = -1;
+	_indexPending = false;
+	_indexUpdated = false;
+	_decoders.setBuildIndex(false);
+	_thumbDecoder.setBuildIndex(false);
+	clearBuffer();
 }
 
 /*! \brief Destroyer
@@ -24,9 +36,97 @@ ImagesBuffer::ImagesBuffer(const unsigned maxsize = 1) : _maxsize(maxsize)
 */
 ImagesBuffer::~ImagesBuffer()
 {
+	delete _seeker;
+	delete _prefetcher;
 	_buffer.clear();
 }
 
+/*! \brief resize the buffer
+*
+*	Change the number of frames kept in the buffer. If a video is loaded the
+*	buffer is refilled around the current frame.
+*
+*	@param maxsize max size of the buffer
+*/
+void ImagesBuffer::setMaxSize(const unsigned maxsize)
+{
+	if (maxsize == _maxsize || maxsize == 0)
+		return;
+
+	qint64 current = _filled ? slot(_mid).num : -1;
+
+	_maxsize = maxsize;
+	_mid = (_maxsize - 1) / 2;
+	_prefetcher->setCapacity(2 * _maxsize);
+	clearBuffer();
+	pinFrames(_pinned);
+
+	if (current != -1)
+		seekToFrame(current);
+}
+
+/*! \brief change the cache budget
+*
+*	Change the max number of bytes used by the frames kept across seeks.
+*
+*	@param bytes max number of bytes
+*/
+void ImagesBuffer::setCacheBudget(const qint64 bytes)
+{
+	_cache.setBudget(bytes);
+}
+
+/*! \brief pin frames in the cache
+*
+*	Keep in the cache the frames around the given ones (e.g. the markers
+*	boundaries), the whole buffer window centered on each of them is pinned
+*	so that jumping there doesn't decode anything.
+*
+*	@param nums frame numbers
+*/
+void ImagesBuffer::pinFrames(const QList<qint64> &nums)
+{
+	_pinned = nums;
+
+	QSet<qint64> pins;
+	for (qint64 num : nums) {
+		for (qint64 i = num - _mid; i < num - _mid + _maxsize; ++i)
+			pins.insert(i);
+	}
+	_cache.setPinnedFrames(pins);
+}
+
+/*! \brief change the thumbnails size
+*
+*	Change the size of the frames given by getThumbnails, the ones decoded
+*	before are dropped.
+*
+*	@param size box the thumbnails fit in, keeping the video aspect ratio
+*/
+void ImagesBuffer::setThumbnailSize(const QSize &size)
+{
+	if (size == _thumbSize)
+		return;
+
+	_thumbSize = size;
+	_thumbCache.clear();
+	_thumbReady = false; // reopened with the new size when needed
+}
+
+/*! \brief enable the filmstrip
+*
+*	Enable or disable the filmstrip of the keyframes, made in background
+*	from the next loaded video
+*
+*	@param enable make the filmstrip or not
+*/
+void ImagesBuffer::setFilmstripEnabled(const bool enable)
+{
+	_filmstripEnabled = enable;
+	if (!enable)
+		_filmstrip.clear();
+}
+
 /*! \brief retrieve the frame with the given frame number.
 *
 *   Checks if the frame is already in the buffer, if not, reseek and refill the buffer
@@ -39,6 +139,7 @@ bool ImagesBuffer::getFrame(Frame &f, const qint64 num)
 {
 	if (!isVideoLoaded())
 		return false;
+	updateIndex();
 
 	if (num < 0)
 		return false;
@@ -55,7 +156,7 @@ bool ImagesBuffer::getFrame(Frame &f, const qint64 num)
 		return false;
 	}
 
-	f = _buffer[_mid];
+	f = slot(_mid);
 	return true;
 }
 
@@ -65,6 +166,8 @@ bool ImagesBuffer::getFrame(Frame &f, const qint64 num)
 *	the frame BUT DO NOT UPDATE THE BUFFER.
 *	The buffer will be updated only when calling seekToFrame().
 *	This is usefull when we the video is in playback and we want just one image.
+*	When the video has no frame with that number the next one is given, with
+*	its own number.
 *
 *	@param p where the image will be stored
 *	@param num number of the frame
@@ -74,6 +177,7 @@ bool ImagesBuffer::getSingleFrame(Frame &f, const qint64 num)
 {
 	if (!isVideoLoaded())
 		return false;
+	updateIndex();
 
 	if (num < 0)
 		return false;
@@ -85,14 +189,23 @@ bool ImagesBuffer::getSingleFrame(Frame &f, const qint64 num)
 		return true;
 	}
 
+	// decoded before?
+	if (_cache.get(num, f))
+		return true;
+
 	// go and get that
-	QImage img;
-	if (!_decoder.seekToAndGetFrame(num, img, &f.pts, &f.time)) {
+	bool ok = _prefetcher->takeFrame(num, f);
+	if (!ok) {
+		QVideoDecoder *decoder = _decoders.acquire(num);
+		ok = decoder && decoder->seekToAndGetFrame(num, f.img, &f.num, &f.time) && f.num >= num;
+		if (decoder)
+			_decoders.release(decoder);
+	}
+	if (!ok) {
 		QMessageBox::critical(NULL, "Error", "Error seeking and decoding the frame");
 		return false;
 	}
-	image2Pixmap(img, f.img);
-	f.num = num;
+	_cache.insert(f);
 
 	return true;
 }
@@ -109,105 +222,139 @@ bool ImagesBuffer::seekToFrame(const qint64 num)
 	if (!isVideoLoaded())
 		return false;
 
-	if (_buffer.size() != 0) {
-		if (_buffer[_mid].num == num) // already set
-			return true;
-	}
+	if (_filled && slot(_mid).num == num) // already set
+		return true;
 
-	qint64 startFrameNumber = num - ((_maxsize - 1) / 2);
+	qint64 newBase = num - _mid;
+	qint64 startFrameNumber = newBase;
 	int numElements = _maxsize;
-	bool addBack = true;
-
-	// no overlap if the buffer is empty
-	if (_buffer.size() != 0) {
-
-		// It may happen that the mid element is a non valid frame 
-		if (_buffer[_mid].num != -1) {
-
-			qint64 dist = num - _buffer[_mid].num; // distance between old and new buffer
-			unsigned distAbs = abs(dist);
-			bool overlap = distAbs < _maxsize; // overlap between old and new buffer
-
-			if (overlap) {
-				qint64 numOverlap = _maxsize - distAbs; // num elements overlapping
-				if (dist > 0) { // seeking forward so erase first elements of the buffer
-					startFrameNumber += numOverlap; // update start frame number
-					_buffer.erase(_buffer.begin(), _buffer.begin() + distAbs);
-				}
-				else {
-					_buffer.erase(_buffer.end() - distAbs, _buffer.end());
-					addBack = false;
-				}
-				numElements -= numOverlap;
+	qint64 direction = 1;
+
+	// no overlap if the buffer is empty.
+	// It may happen that the mid element is a non valid frame, reset in that case
+	if (_filled && slot(_mid).num != -1) {
+
+		qint64 dist = newBase - _base; // distance between old and new buffer
+		direction = dist;
+		unsigned distAbs = abs(dist);
+		bool overlap = distAbs < _maxsize; // overlap between old and new buffer
+
+		if (overlap) {
+			// slide the ring, elements going out of the buffer are reused for
+			// the ones coming in
+			if (dist > 0) { // seeking forward, first elements become the last ones
+				_head = (_head + distAbs) % _maxsize;
+				startFrameNumber = newBase + _maxsize - distAbs;
 			}
-			else { // no overlap, clear
-				_buffer.clear();
+			else {
+				_head = (_head + _maxsize - distAbs) % _maxsize;
 			}
-		}
-		else { // not valid mid, reset
-			_buffer.clear();
+			numElements = distAbs;
 		}
 	}
+	_base = newBase;
+	_filled = true;
 
 	// fill the buffer from startNumber with numElements elements
-	if (!fillBuffer(startFrameNumber, numElements, addBack)) {
+	if (!fillBuffer(startFrameNumber, numElements)) {
 		// QMessageBox::critical(NULL, "Error", "Seek failed");
-		// TODO: buffer inconsistent, what to do?
+		// the buffer is not consistent, next seek will refill it entirely
+		_filled = false;
 		return false;
 	}
 
+	// decode in background the frames we are going to need next
+	prefetch(direction);
 	return true;
-	// emit 
 }
 
 /*! \brief fill the buffer
 *
-*	Fill the buffer starting from the gieven start fram number and adding
-*	numElements elements in front or back based on addBack.
+*	Fill numElements elements of the buffer starting from the given start
+*	frame number. Elements must belong to the current window. Frames are
+*	numbered by the decoder: the numbers the video doesn't have (skipped or
+*	merged by the decoder) are left empty.
 *   @param startFrameNumber start frame number
-*   @param numElements num elements to add
-*   @param addBack put elements back or in front
+*   @param numElements num elements to fill
 *	@return succes or not
 */
 bool ImagesBuffer::fillBuffer(
 	const qint64 startFrameNumber, 
-	const int numElements, 
-	const bool addBack
+	const int numElements
 )
 {
-	bool endofstream = false;
-	// Seek to the first frame
-	if (!_decoder.seekFrame((startFrameNumber >= 0) ? startFrameNumber : 0)) {
-		return false;
-	}
+	PROFILE_SCOPE("buffer fill");
 
-	for (int i = 0; i < numElements; ++i) {
-		int actualFrameNumber = startFrameNumber + i;
-		Frame f;
+	bool ok = true;
+	bool endofstream = false;
+	QVideoDecoder *decoder = 0;		// taken from the pool when first needed
+	qint64 decoderFrameNumber = -1; // frame the decoder is positioned on
+	Frame ahead;					// decoded past a missing frame, for a next element
+
+	for (int i = 0; ok && i < numElements; ++i) {
+		qint64 actualFrameNumber = startFrameNumber + i;
+		Frame &f = slot(actualFrameNumber - _base);
+		f = Frame();
 		//	if out of bound retrieve and fill the image
-		if (actualFrameNumber >= 0 && actualFrameNumber < numFrames && !endofstream) {
+		if (actualFrameNumber >= 0 && actualFrameNumber < numFrames) {
 
-			// Decode the frame
-			QImage img;
-			if (!_decoder.getFrame(img, &f.pts, &f.time)) {
-				QMessageBox::critical(NULL, "Error", "Error decoding the frame");
-				// TODO: buffer inconsistent, what to do?
-				return false;
+			// Decoded before?
+			if (_cache.get(actualFrameNumber, f))
+				continue;
+
+			// Already decoded in background, or by the decoder going past a missing one?
+			bool ready = _prefetcher->takeFrame(actualFrameNumber, f);
+			if (!ready && ahead.num == actualFrameNumber) {
+				f = ahead;
+				ready = true;
+			}
+			else if (!ready && ahead.num > actualFrameNumber) {
+				continue;
 			}
 
-			// Update the buffer with this Frame
-			image2Pixmap(img, f.img);
-			f.num = actualFrameNumber;
+			if (!ready && !endofstream) {
+				// The decoder closest to the frame
+				if (!decoder && !(decoder = _decoders.acquire(actualFrameNumber))) {
+					ok = false;
+					break;
+				}
+
+				// Seek to the frame if the decoder is not already there
+				if (decoderFrameNumber != actualFrameNumber) {
+					if (!decoder->seekFrame(actualFrameNumber)) {
+						ok = false;
+						break;
+					}
+				}
 
-			// Seek next
-			endofstream = !_decoder.seekNextFrame();
+				// Decode the frame
+				if (!decoder->getFrame(f.img, &f.num, &f.time)) {
+					QMessageBox::critical(NULL, "Error", "Error decoding the frame");
+					// TODO: buffer inconsistent, what to do?
+					ok = false;
+					break;
+				}
+				// Seek next
+				endofstream = !decoder->seekNextFrame();
+				decoderFrameNumber = f.num + 1;
+
+				ready = f.num == actualFrameNumber;
+				if (!ready) {
+					if (f.num > actualFrameNumber)
+						ahead = f;
+					f = Frame();
+				}
+			}
+
+			// Update the buffer with this Frame
+			if (ready)
+				_cache.insert(f);
 		}
-		if (addBack)
-			_buffer.push_back(f);
-		else
-			_buffer.emplace(_buffer.begin() + i, f);
 	}
-	if (_buffer[_mid].num == -1) {
+	if (decoder)
+		_decoders.release(decoder);
+
+	if (!ok || slot(_mid).num == -1) {
 		return false;
 	}
 
@@ -229,7 +376,7 @@ bool ImagesBuffer::getFrameByTime(Frame &f, const qint64 ms)
 	if (!isVideoLoaded())
 		return false;
 
-	qint64 num = _decoder.getNumFrameByTime(ms);
+	qint64 num = _decoders.getInfo()->getNumFrameByTime(ms);
 	if (!getFrame(f, num)) {
 		QMessageBox::critical(NULL,"Error","Seek failed, invalid time");
 		return false;
@@ -251,12 +398,100 @@ bool ImagesBuffer::getFrameByTimePercentage(Frame &f, const double perc)
 	if (!isVideoLoaded())
 		return false;
 
-	qint64 ms = videoLength * perc;
+	qint64 ms = getVideoLengthMs() * perc;
 	bool ok = getFrameByTime(f, ms);
 	return ok;
 }
 
 
+/**************************************
+*******    ASYNCHRONOUS SEEKS    ******
+***************************************/
+
+/*! \brief request a frame without waiting
+*
+*	Ask for a frame, the seeks requested before are cancelled. Frames in the
+*	buffer or in the cache are given at once, the others are decoded in
+*	background, meanwhile the filmstrip thumbnail of their keyframe is given
+*	as a preview. The buffer is not moved.
+*	@param num frame number
+*	@return ticket of the request, to be given to takeRequestedFrame()
+*/
+quint64 ImagesBuffer::requestFrame(const qint64 num)
+{
+	_seekHit = Frame();
+	_seekPreview = Frame();
+	if (!isVideoLoaded() || num < 0)
+		return _seekTicket = _seeker->cancel();
+	updateIndex();
+
+	// already decoded?
+	int index = isFrameLoaded(num);
+	if (index != -1)
+		_seekHit = _buffer[index];
+	else
+		_cache.get(num, _seekHit);
+
+	if (_seekHit.num != -1)
+		return _seekTicket = _seeker->cancel();
+
+	// the filmstrip shows where the seek is going until the seeker
+	// has something better
+	Frame thumb;
+	if (_filmstrip.getNearest(num, thumb))
+		_seekPreview = thumb;
+	return _seekTicket = _seeker->request(num);
+}
+
+/*! \brief request the frame at a time percentage without waiting
+*
+*	Ask for the frame located at the given percentage of the entire video
+*	length, see requestFrame()
+*	@param perc double value from 0 to 1
+*	@return ticket of the request
+*/
+quint64 ImagesBuffer::requestFrameByTimePercentage(const double perc)
+{
+	if (!isVideoLoaded())
+		return _seeker->cancel();
+
+	qint64 ms = getVideoLengthMs() * perc;
+	return requestFrame(_decoders.getInfo()->getNumFrameByTime(ms));
+}
+
+/*! \brief take the frame of a request
+*
+*	Take the frame of a request made with requestFrame(), if something new
+*	is ready. The exact frame goes in the cache too.
+*	@param ticket ticket of the request
+*	@param f where the frame will be stored, when it is ready
+*	@return state of the request: SeekPreview and SeekExact give a frame
+*/
+SeekState ImagesBuffer::takeRequestedFrame(const quint64 ticket, Frame &f)
+{
+	if (_seekHit.num != -1 && ticket == _seekTicket) {
+		f = _seekHit;
+		_seekHit = Frame();
+		return SeekExact;
+	}
+
+	SeekResult r;
+	SeekState state = _seeker->take(ticket, r);
+	if (state == SeekPending && _seekPreview.num != -1 && ticket == _seekTicket) {
+		f = _seekPreview;
+		_seekPreview = Frame();
+		return SeekPreview;
+	}
+	if (state == SeekPreview || state == SeekExact) {
+		_seekPreview = Frame();
+		f = r;
+		if (state == SeekExact)
+			_cache.insert(f);
+	}
+	return state;
+}
+
+
 /**************************************
 ************    HELPERS    ************
 ***************************************/
@@ -269,40 +504,196 @@ bool ImagesBuffer::getFrameByTimePercentage(Frame &f, const double perc)
 */
 const int ImagesBuffer::isFrameLoaded(const qint64 num)
 {
-	if (num >= 0) {
-		for (int i = 0; i < _buffer.size(); ++i) {
-			if (_buffer[i].num == num) {
-				return i;
-			}
-		}
+	if (!_filled || num < 0 || num < _base || num >= _base + _maxsize)
+		return -1;
+
+	int index = (_head + (num - _base)) % _maxsize;
+	return (_buffer[index].num == num) ? index : -1;
+}
+
+/*! \brief element of the buffer
+*
+*   Retrieve an element of the buffer by its position in the window.
+*	@param i position, 0 is the first frame of the window
+*	@return the element
+*/
+Frame &ImagesBuffer::slot(const unsigned i)
+{
+	return _buffer[(_head + i) % _maxsize];
+}
+
+/*! \brief empty the buffer
+*
+*   Invalidate all the elements of the buffer.
+*/
+void ImagesBuffer::clearBuffer()
+{
+	_buffer.assign(_maxsize, Frame());
+	_head = 0;
+	_base = 0;
+	_filled = false;
+}
+
+/*! \brief prefetch frames in background
+*
+*   Ask the prefetcher to decode the frames that follow the buffer, or
+*	precede it when moving backward.
+*	@param direction direction of navigation, negative when moving backward
+*/
+void ImagesBuffer::prefetch(const qint64 direction)
+{
+	qint64 first = _base;
+	if (direction < 0)
+		_prefetcher->prefetch(first - _maxsize, _maxsize);
+	else
+		_prefetcher->prefetch(first + _maxsize, _maxsize);
+}
+
+/*! \brief open the thumbnails decoder
+*
+*   Open the video again in the thumbnails decoder, with the output size
+*	fitted in the thumbnails box.
+*	@return success or not
+*/
+bool ImagesBuffer::openThumbnails()
+{
+	if (_thumbReady)
+		return true;
+
+	QSize size = QSize(getFrameWidth(), getFrameHeight()).scaled(_thumbSize, Qt::KeepAspectRatio);
+	if (size.isEmpty())
+		return false;
+
+	_thumbDecoder.setOutputSize(size.width(), size.height());
+	_thumbReady = _thumbDecoder.openFile(getPath()) && _thumbDecoder.isOk();
+	_thumbNext = -1;
+
+	// it may have been opened before the index was stored
+	if (_thumbReady && !_thumbDecoder.hasIndex() && _index.isValid())
+		_thumbDecoder.setIndex(_index);
+	return _thumbReady;
+}
+
+/*! \brief decode a thumbnail
+*
+*   Decode a frame with the thumbnails decoder, seeking only when it isn't
+*	already positioned on it, so consecutive thumbnails are decoded in a row.
+*	@param f where the thumbnail will be stored
+*	@param num frame number
+*	@return success or not, false when the video has no frame with that number
+*/
+bool ImagesBuffer::decodeThumbnail(Frame &f, const qint64 num)
+{
+	if (!openThumbnails())
+		return false;
+
+	if (_thumbNext != num && !_thumbDecoder.seekFrame(num)) {
+		_thumbNext = -1;
+		return false;
+	}
+
+	if (!_thumbDecoder.getFrame(f.img, &f.num, &f.time)) {
+		_thumbNext = -1;
+		return false;
+	}
+	_thumbNext = _thumbDecoder.seekNextFrame() ? f.num + 1 : -1;
+
+	return f.num == num;
+}
+
+/*! \brief use the packets index built in background
+*
+*   Give the packets index to the decoders as soon as the IndexScanner has
+*	built it, updating number of frames and length with the exact ones.
+*	Frames are numbered on the timeline from now on: the ones decoded with
+*	the predicted numbers are dropped and the buffer is filled again around
+*	the frame that was in the middle, found by its time. The filmstrip waits
+*	for the index too, so the numbers it stores are final.
+*	It's called by the methods that use frame numbers, the UI is told by
+*	takeIndexUpdate().
+*/
+void ImagesBuffer::updateIndex()
+{
+	if (!_indexPending || _indexScanner.isRunning())
+		return;
+	_indexPending = false;
+
+	if (_indexScanner.take(_index)) {
+		_indexUpdated = true;
+		qint64 time = _filled ? slot(_mid).time : -1;
+
+		_seeker->cancel();
+		_seekHit = Frame();
+		_seekPreview = Frame();
+		_prefetcher->clear();
+		_decoders.setIndex(_index);
+		if (_thumbReady)
+			_thumbDecoder.setIndex(_index);
+		_thumbNext = -1;
+
+		clearBuffer();
+		_cache.clear();
+		_thumbCache.clear();
+
+		numFrames	= _decoders.getInfo()->getNumFrames();
+		videoLength = _decoders.getInfo()->getVideoLengthMs();
+		_prefetcher->setVideo(numFrames);
+
+		// the same frame, with its number on the timeline
+		if (time >= 0 && !seekToFrame(_decoders.getInfo()->getNumFrameByTime(time)))
+			qDebug() << "Seek to the indexed frame failed";
 	}
-	return -1;
+
+	if (_filmstripEnabled)
+		_filmstrip.open(getPath(), QSize(getFrameWidth(), getFrameHeight()), _decoders.getInfo()->getIndex());
+}
+
+/*! \brief the frames have been renumbered?
+*
+*	Use the packets index if it's ready and check if the frames have been
+*	renumbered since the last call: the frame numbers kept outside of the
+*	buffer must be found again by their time.
+*	@see updateIndex()
+*/
+bool ImagesBuffer::takeIndexUpdate()
+{
+	if (isVideoLoaded())
+		updateIndex();
+	bool updated = _indexUpdated;
+	_indexUpdated = false;
+	return updated;
+}
+
+/*! \brief the video is being indexed
+*
+*	Check if the packets index is still being built: until then the frame
+*	numbers are predicted and change when it's ready.
+*	@see updateIndex()
+*/
+bool ImagesBuffer::isIndexPending()
+{
+	return _indexPending;
 }
 
-/*! \brief from QImage to QPixmap.
+/*! \brief Get the index scanner
 *
-*   Convert a QImage to a QPixmap.
-*	@param img as QImage
-*	@param pixmap as QPixmap
+*	Retrieve the thread that builds the packets index, its finished() signal
+*	tells when takeIndexUpdate() has an index to give to the decoders.
 */
-void ImagesBuffer::image2Pixmap(QImage &img, QPixmap &pixmap)
+QThread *ImagesBuffer::getIndexScanner()
 {
-	// Convert the QImage to a QPixmap for display
-	pixmap = QPixmap(img.size());
-	QPainter painter;
-	painter.begin(&pixmap);
-	painter.drawImage(0, 0, img);
-	painter.end();
+	return &_indexScanner;
 }
 
 void ImagesBuffer::dumpBuffer()
 {
 	qDebug() << "Dump del buffer:";
-	for (int i = 0; i < _buffer.size(); ++i) {
-		if (_buffer[i].num == -1)
-			qDebug() << "\t" << QString("%1  -  -  -").arg(i);
+	for (unsigned i = 0; i < _maxsize; ++i) {
+		Frame &f = slot(i);
+		if (f.num == -1)
+			qDebug() << "\t" << QString("%1  -  -").arg(i);
 		else
-			qDebug() << "\t" << QString("%1 %2 %3 %4 %5").arg(i).arg(_buffer[i].num).arg(_buffer[i].pts).arg(_buffer[i].time).arg((i == _mid) ? " <-" : "");
+			qDebug() << "\t" << QString("%1 %2 %3 %4").arg(i).arg(f.num).arg(f.time).arg((i == _mid) ? " <-" : "");
 	}
 }
 
@@ -313,20 +704,57 @@ void ImagesBuffer::dumpBuffer()
 
 /*! \brief load a video.
 *
-*   Open and load a video by using ffmpeg's decoder.
+*   Open and load a video by using ffmpeg's decoder. The pool decoders and
+*	the thumbnails decoder share the cores with each other and with the
+*	playback engine, so by default each codec has a couple of threads.
 *	@param fileName path to the video
+*	@param threading how the codecs spread the decoding over threads
+*	@param threads number of threads of each codec, 0 = one per core
 */
-bool ImagesBuffer::loadVideo(const QString fileName)
+bool ImagesBuffer::loadVideo(
+	const QString fileName,
+	const QVideoDecoder::ThreadingMode threading,
+	const int threads
+)
 {
-	_buffer.clear();
-	_decoder.openFile(fileName);
+	clearBuffer();
+	_prefetcher->clear();
+	_seeker->cancel();
+	_seekHit = Frame();
+	_seekPreview = Frame();
+	_filmstrip.clear();
+	_cache.clear();
+	_thumbCache.clear();
+	_thumbReady = false;
+	_indexScanner.clear();
+	_indexPending = false;
+	_indexUpdated = false;
+	_index.clear();
+	_thumbStore.setVideo(fileName);
+	_thumbDecoder.setThreading(threading, threads);
+	_decoders.open(fileName, threading, threads);
+
+	numFrames	= _decoders.getInfo()->getNumFrames();
+	videoLength = _decoders.getInfo()->getVideoLengthMs();
+	frameMs		= _decoders.getInfo()->getFrameMsec();
+
+	if (!_decoders.isOk()) {
+		return false;
+	}
 
-	numFrames	= _decoder.getNumFrames();
-	videoLength = _decoder.getVideoLengthMs();
-	frameMs		= _decoder.getFrameMsec();
+	// The prefetcher borrows the pool decoders too
+	_prefetcher->setVideo(numFrames);
 
-	if (!_decoder.isOk()) {
-		return false;
+	// first time the video is opened: index it without waiting, the
+	// filmstrip starts when it's done
+	if (!_decoders.getInfo()->hasIndex()) {
+		_indexPending = true;
+		_indexScanner.scan(fileName, _decoders.getInfo()->getVideoStream());
+	}
+
+	// keyframes thumbnails for the coarse navigation, in background
+	else if (_filmstripEnabled) {
+		_filmstrip.open(fileName, QSize(getFrameWidth(), getFrameHeight()), _decoders.getInfo()->getIndex());
 	}
 
 	// Seek to the first frame
@@ -369,8 +797,7 @@ void ImagesBuffer::getImagesBuffer(std::vector<Frame> &v, const int mid, const i
 					v.push_back(f);
 				}
 				else {
-					index = _mid;
-					v.push_back(_buffer[index]);
+					v.push_back(slot(_mid));
 				}
 			}
 			else { // already in the buffer
@@ -383,6 +810,88 @@ void ImagesBuffer::getImagesBuffer(std::vector<Frame> &v, const int mid, const i
 	}//for
 }
 
+/*! \brief get num thumbnails centered on mid
+*
+*   Retrieve "num" frames centered on "mid", scaled to fit the thumbnails
+*	size, see getThumbnail(). Frames out of the video are left empty.
+*	@param v where Frames will be stored
+*	@param mid number of the middle element
+*	@param num number of elements to retrieve
+*/
+void ImagesBuffer::getThumbnails(std::vector<Frame> &v, const qint64 mid, const int num)
+{
+	qint64 startFrameNumber = mid - ((num - 1) / 2);
+
+	for (int i = 0; i < num; ++i) {
+		Frame f;
+		if (!getThumbnail(f, startFrameNumber + i))
+			f = Frame();
+		v.push_back(f);
+	}
+}
+
+/*! \brief get a thumbnail
+*
+*   Retrieve a frame scaled to fit the thumbnails size. It doesn't move the
+*	buffer: it comes from the thumbnails cache, from the thumbnails stored by
+*	a previous session, is scaled from a full frame already decoded or is
+*	decoded directly at the thumbnails size (as a full frame by a pool
+*	decoder if the thumbnails decoder can't be opened).
+*	@param f where the Frame will be stored
+*	@param num frame number
+*	@param decode decode it if needed, or give only what's ready at once
+*	@return success or not, false when it has to be decoded and decode is false
+*/
+bool ImagesBuffer::getThumbnail(Frame &f, const qint64 num, const bool decode)
+{
+	if (!isVideoLoaded())
+		return false;
+	updateIndex();
+
+	if (num < 0 || num >= numFrames)
+		return false;
+	if (_thumbCache.get(num, f))
+		return true;
+
+	// stored by a previous session? they are numbered on the timeline
+	QImage img;
+	if (_decoders.getInfo()->hasIndex() && _thumbStore.get(num, _thumbSize, img)) {
+		f.img = img;
+		f.num = num;
+		_thumbCache.insert(f);
+		return true;
+	}
+
+	// full frame already decoded? scaling it is cheaper than decoding
+	int index = isFrameLoaded(num);
+	bool full = index != -1 || _cache.get(num, f);
+	if (index != -1)
+		f = _buffer[index];
+	if (!full && !decode)
+		return false;
+
+	// thumbnails decoder not available, decode the full frame with a pool
+	// decoder: the buffer and the prefetcher stay where the player is
+	bool ok = full || decodeThumbnail(f, num);
+	if (!ok) {
+		QVideoDecoder *decoder = _decoders.acquire(num);
+		ok = full = decoder && decoder->seekToAndGetFrame(num, f.img, &f.num, &f.time);
+		if (decoder)
+			_decoders.release(decoder);
+	}
+
+	// the video may have no frame with that number
+	if (!ok || f.num != num)
+		return false;
+	if (full)
+		f.img = f.img.scaled(_thumbSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+	_thumbCache.insert(f);
+	if (_decoders.getInfo()->hasIndex())
+		_thumbStore.put(num, _thumbSize, f.img);
+	return true;
+}
+
 /*! \brief retrieve the middle (current) frame
 *
 *   Retrieve the middle frame image
@@ -390,7 +899,7 @@ void ImagesBuffer::getImagesBuffer(std::vector<Frame> &v, const int mid, const i
 *	@return success or not
 */
 bool ImagesBuffer::getMidFrame(Frame &f) {
-	f = _buffer[_mid];
+	f = slot(_mid);
 	return true;
 }
 
@@ -400,23 +909,35 @@ bool ImagesBuffer::getMidFrame(Frame &f) {
 */
 bool ImagesBuffer::isVideoLoaded()
 {
-	return _decoder.isOk();
+	return _decoders.isOk();
 }
 
 
+/*! \brief Get buffer size
+*
+*	Retrieve the max number of frames kept in the buffer
+*/
+unsigned ImagesBuffer::getMaxSize() {
+	return _maxsize;
+}
+
 /*! \brief Get number of frames
 *
-*	Retrieve the number of frames
+*	Retrieve the number of frames, exact once the packets index is ready
 */
 qint64 ImagesBuffer::getNumFrames() {
+	if (isVideoLoaded())
+		updateIndex();
 	return numFrames;
 }
 
-/*! \brief Get number of frames
+/*! \brief Get video length
 *
-*	Retrieve the number of frames
+*	Retrieve the video length in ms, exact once the packets index is ready
 */
 qint64 ImagesBuffer::getVideoLengthMs() {
+	if (isVideoLoaded())
+		updateIndex();
 	return videoLength;
 }
 
@@ -430,11 +951,11 @@ qint64 ImagesBuffer::getVideoLengthMs() {
 */
 bool ImagesBuffer::getDimensions(double &ratio, int *w, int *h) 
 {
-	if (!isVideoLoaded() || _buffer.size()==0)
+	if (!isVideoLoaded() || !_filled)
 		return false;
 
-	int wi = _buffer[_mid].img.width();
-	int he = _buffer[_mid].img.height();
+	int wi = slot(_mid).img.width();
+	int he = slot(_mid).img.height();
 	ratio = wi / (double) he;
 	if (w)
 		*w = wi;
@@ -448,7 +969,19 @@ bool ImagesBuffer::getDimensions(double &ratio, int *w, int *h)
 *	Retrieve video path
 */
 QString ImagesBuffer::getPath() {
-	return _decoder.getPath();
+	return _decoders.getInfo()->getPath();
+}
+
+/*! \brief Get the packets index
+*
+*	Retrieve the packets index the frames are numbered with, not valid while
+*	it is being built. The other decoders of the video take it from here, so
+*	they number the frames in the same way even when it couldn't be stored.
+*/
+const FrameIndex &ImagesBuffer::getIndex() {
+	if (isVideoLoaded())
+		updateIndex();
+	return _decoders.getInfo()->getIndex();
 }
 
 /*! \brief Get video path
@@ -456,7 +989,7 @@ QString ImagesBuffer::getPath() {
 *	Retrieve video path
 */
 QString ImagesBuffer::getType() {
-	return _decoder.getType();
+	return _decoders.getInfo()->getType();
 }
 
 /*! \brief Get video duration
@@ -465,8 +998,8 @@ QString ImagesBuffer::getType() {
 */
 QString ImagesBuffer::getDuration() {
 	int hours, mins, secs, us;
-	secs = videoLength / 1000;
-	us = videoLength % 1000;
+	secs = getVideoLengthMs() / 1000;
+	us = getVideoLengthMs() % 1000;
 	mins = secs / 60;
 	secs %= 60;
 	hours = mins / 60;
@@ -480,7 +1013,7 @@ QString ImagesBuffer::getDuration() {
 *	Retrieve video time base
 */
 double ImagesBuffer::getTimeBase() {
-	return _decoder.getTimeBase();
+	return _decoders.getInfo()->getTimeBase();
 }
 
 /*! \brief Get video frame rate
@@ -488,7 +1021,7 @@ double ImagesBuffer::getTimeBase() {
 *	Retrieve video frame rate
 */
 double ImagesBuffer::getFrameRate() {
-	return _decoder.getFrameRate();
+	return _decoders.getInfo()->getFrameRate();
 }
 
 /*! \brief Get video frame ms (theorycal)
@@ -496,7 +1029,7 @@ double ImagesBuffer::getFrameRate() {
 *	Retrieve video frame ms (theorycal)
 */
 double ImagesBuffer::getFrameMsec() {
-	return _decoder.getFrameMsec();
+	return _decoders.getInfo()->getFrameMsec();
 }
 
 /*! \brief Get video frame ms (real)
@@ -504,7 +1037,7 @@ double ImagesBuffer::getFrameMsec() {
 *	Retrieve video frame ms (real)
 */
 double ImagesBuffer::getFrameMsecReal() {
-	return _decoder.getFrameMsecReal();
+	return _decoders.getInfo()->getFrameMsecReal();
 }
 
 /*! \brief Get frame width
@@ -512,7 +1045,7 @@ double ImagesBuffer::getFrameMsecReal() {
 *	Get frame width
 */
 int ImagesBuffer::getFrameWidth() {
-	return _decoder.getFrameWidth();
+	return _decoders.getInfo()->getFrameWidth();
 }
 
 /*! \brief Get frame height
@@ -520,7 +1053,7 @@ int ImagesBuffer::getFrameWidth() {
 *	Get frame height
 */
 int ImagesBuffer::getFrameHeight() {
-	return _decoder.getFrameHeight();
+	return _decoders.getInfo()->getFrameHeight();
 }
 
 /*! \brief Get video bitrate
@@ -528,7 +1061,7 @@ int ImagesBuffer::getFrameHeight() {
 *	Get video bitrate
 */
 QString ImagesBuffer::getBitrate() {
-	return _decoder.getBitrate();
+	return _decoders.getInfo()->getBitrate();
 }
 
 /*! \brief Get string of programs used to make the video
@@ -537,7 +1070,7 @@ QString ImagesBuffer::getBitrate() {
 */
 QString ImagesBuffer::getProgramsString()
 {
-	return _decoder.getProgramsString();
+	return _decoders.getInfo()->getProgramsString();
 }
 
 /*! \brief Get string of metadata
@@ -546,5 +1079,5 @@ QString ImagesBuffer::getProgramsString()
 */
 QString ImagesBuffer::getMetadataString()
 {
-	return _decoder.getMetadataString();
+	return _decoders.getInfo()->getMetadataString();
 }
@@ -2,15 +2,18 @@
 #define IMAGESBUFFER_H
 
 #include <QVideoDecoder.h>
+#include <DecoderPool.h>
+#include <FramePrefetcher.h>
+#include <FrameSeeker.h>
+#include <Filmstrip.h>
+#include <ThumbnailStore.h>
+#include <IndexScanner.h>
+#include <FrameCache.h>
 #include <QWidget>
 #include <vector>
 
-struct Frame {
-	QPixmap img;
-	qint64 num = -1;		//!< absolute frame number
-	qint64 time = -1;		//!< frame timestamp
-	qint64 pts;				//!< decoder presentation timestamp, NOT USED
-};
+#define FRAMECACHE_DEFAULT_BUDGET	((qint64) 2 * 1024 * 1024 * 1024)	// 2 GB
+#define THUMBCACHE_DEFAULT_BUDGET	((qint64) 256 * 1024 * 1024)		// 256 MB
 
 /*!
 *	@brief Class used to manage a buffer of images
@@ -22,15 +25,64 @@ struct Frame {
 *	
 *	There is a overlap control system between the current buffer and the wanted
 *	target buffer so that we can skip decoding some images.
+*	The buffer is a fixed size ring addressed by frame number: looking for a
+*	frame and sliding the buffer in both directions don't move any element.
+*	A background thread decodes the frames that follow (or precede) the buffer
+*	in the direction of navigation, so that moving frame by frame rarely has
+*	to wait for the decoder. Both take their decoder from a DecoderPool, which
+*	gives the one closest to the wanted frame, so they don't undo each other's
+*	position.
+*	Every decoded frame also goes into a FrameCache, so that going back to a
+*	frame seen before (e.g. jumping between markers) doesn't decode it again.
+*	Seeks can also be requested without waiting (e.g. while dragging the
+*	slider): a FrameSeeker decodes them in background, a newer request
+*	cancels the older ones, and the keyframe of the GOP is given first.
+*	A Filmstrip with the thumbnails of all the keyframes is made in background
+*	when a video is loaded: it gives a preview of any seek at once.
+*	Opening a video doesn't wait for its packets index: when it has not been
+*	stored before an IndexScanner builds it in background, meanwhile number
+*	of frames and length are estimated; the exact ones replace them as soon
+*	as the index is ready. From then on frame numbers and times come from its
+*	Timeline, exact with a variable frame rate too.
+*	Thumbnails (e.g. the previews) come from a second decoder that converts
+*	frames directly to the thumbnail size, decoding them at reduced
+*	resolution when the codec can; they have their own cache, and are kept
+*	on disk by a ThumbnailStore so a video opened again doesn't decode them.
 */
 class ImagesBuffer
 {
 
-	QVideoDecoder		_decoder;	//!< ffmpeg decoder
+	DecoderPool			_decoders;	//!< ffmpeg decoders, shared with the prefetcher
+	FramePrefetcher		*_prefetcher;	//!< background decoder
+	FrameSeeker			*_seeker;	//!< decoder of the asynchronous seeks
+	FrameCache			_cache;		//!< frames decoded before
 
-	std::vector<Frame>	_buffer;	//!< Frame array
+	std::vector<Frame>	_buffer;	//!< Frame ring
 	unsigned			_maxsize;
 	unsigned			_mid;		//!< mid element index
+	unsigned			_head;		//!< ring index of the first element
+	qint64				_base;		//!< frame number of the first element
+	bool				_filled;	//!< the ring holds a valid window
+	QList<qint64>		_pinned;	//!< frames whose window is pinned in the cache
+
+	Frame				_seekHit;	//!< frame of the last seek, found without decoding
+	Frame				_seekPreview;	//!< filmstrip thumbnail of the last seek
+	quint64				_seekTicket;	//!< ticket of the last seek
+
+	Filmstrip			_filmstrip;	//!< thumbnails of all the keyframes
+	bool				_filmstripEnabled;	//!< make the filmstrip when a video is loaded
+
+	QVideoDecoder		_thumbDecoder;	//!< decoder of the thumbnails
+	FrameCache			_thumbCache;	//!< thumbnails decoded before
+	QSize				_thumbSize;		//!< box the thumbnails fit in
+	bool				_thumbReady;	//!< the thumbnails decoder is open
+	qint64				_thumbNext;		//!< frame the thumbnails decoder is on
+	ThumbnailStore		_thumbStore;	//!< thumbnails of the previous sessions
+
+	IndexScanner		_indexScanner;	//!< builds the packets index in background
+	bool				_indexPending;	//!< the video is being indexed
+	bool				_indexUpdated;	//!< frames renumbered, not told by takeIndexUpdate() yet
+	FrameIndex			_index;			//!< index built in background, for the decoders opened later
 
 	//	Help variables
 	int		frameMs;				//!< ms of a single frame
@@ -38,14 +90,18 @@ class ImagesBuffer
 	qint64	videoLength;			//!< ms of the entire video
 
 	//  Helpers
-	void image2Pixmap(QImage &img, QPixmap &pixmap);
 	void dumpBuffer();
 	bool fillBuffer(
 		const qint64 startFrameNumber,
-		const int numElements,
-		const bool addBack
+		const int numElements
 	);
 	const int isFrameLoaded(const qint64 num);
+	Frame &slot(const unsigned i);
+	void clearBuffer();
+	void prefetch(const qint64 direction);
+	bool openThumbnails();
+	bool decodeThumbnail(Frame &f, const qint64 num);
+	void updateIndex();
 
 	bool seekToFrame(const qint64 num);
 
@@ -60,17 +116,38 @@ public:
 	bool getFrameByTimePercentage(Frame &f, const double perc);
 	bool getSingleFrame(Frame &f, const qint64 num);
 
+	//  Asynchronous seeks
+	quint64		requestFrame(const qint64 num);
+	quint64		requestFrameByTimePercentage(const double perc);
+	SeekState	takeRequestedFrame(const quint64 ticket, Frame &f);
+
 	//  Video actions
-	bool loadVideo(const QString fileName);
+	bool loadVideo(
+		const QString fileName,
+		const QVideoDecoder::ThreadingMode threading = QVideoDecoder::ThreadingAuto,
+		const int threads = DECODERPOOL_THREADS
+	);
+	void setMaxSize(const unsigned maxsize);
+	void setCacheBudget(const qint64 bytes);
+	void pinFrames(const QList<qint64> &nums);
+	void setThumbnailSize(const QSize &size);
+	void setFilmstripEnabled(const bool enable);
+	bool takeIndexUpdate();
 
 	//  Getters
 	void	getImagesBuffer(std::vector<Frame> &v, const int mid, const int num = 0);
+	void	getThumbnails(std::vector<Frame> &v, const qint64 mid, const int num);
+	bool	getThumbnail(Frame &f, const qint64 num, const bool decode = true);
 	bool	isVideoLoaded();
+	unsigned getMaxSize();
 
 	qint64	getNumFrames();
 	qint64	getVideoLengthMs();
 	bool	getDimensions(double &ratio, int *w=0, int *h=0);
 	QString getPath();
+	const FrameIndex &getIndex();
+	bool	isIndexPending();
+	QThread	*getIndexScanner();
 	QString getType();
 	QString getDuration();
 	double	getTimeBase();
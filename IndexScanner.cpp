@@ -0,0 +1,99 @@
+#include <QDebug>
+
+#include "IndexScanner.h"
+
+/*! \brief Create the scanner
+*
+*	Create the scanner, the scan starts with scan()
+*/
+IndexScanner::IndexScanner()
+{
+	_stream = -1;
+	_ready = false;
+}
+
+/*! \brief Destroyer
+*
+*	Stop the scan in progress, if any, and wait for it
+*/
+IndexScanner::~IndexScanner()
+{
+	_abort.store(1);
+	wait();
+}
+
+/*! \brief Worker loop
+*
+*	Read all the packets of the video, without decoding them, and store the
+*	index in its sidecar file.
+*/
+void IndexScanner::run()
+{
+	FrameIndex index;
+	if (!index.build(_fileName, _stream, &_abort))
+		return;
+
+	// not being able to write next to the video is not an error
+	if (!index.save(_fileName))
+		qDebug() << "Can't store the index in" << FrameIndex::sidecarPath(_fileName);
+
+	QMutexLocker locker(&_mutex);
+	_index = index;
+	_ready = true;
+}
+
+
+/**************************************
+*********    SCAN ACTIONS    **********
+***************************************/
+
+/*! \brief scan a video
+*
+*	Start building the index of a video, the scan of the previous video is
+*	stopped and its index dropped.
+*	@param fileName path of the video
+*	@param streamIndex index of the video stream
+*/
+void IndexScanner::scan(const QString fileName, const int streamIndex)
+{
+	clear();
+
+	_fileName = fileName;
+	_stream = streamIndex;
+	start(QThread::LowPriority);
+}
+
+/*! \brief clear the scanner
+*
+*	Stop the scan in progress, if any, and drop its index. The scan gives
+*	up its current read, so this doesn't wait for the rest of the file.
+*/
+void IndexScanner::clear()
+{
+	_abort.store(1);
+	wait();
+	_abort.store(0);
+
+	QMutexLocker locker(&_mutex);
+	_index.clear();
+	_ready = false;
+}
+
+/*! \brief take the index
+*
+*	Take the index once the scan is over, it can be taken only once.
+*	@param index where the index will be stored
+*	@return false if the scan is still in progress, has failed or the index
+*		has been taken already
+*/
+bool IndexScanner::take(FrameIndex &index)
+{
+	QMutexLocker locker(&_mutex);
+
+	if (!_ready)
+		return false;
+	index = _index;
+	_index.clear();
+	_ready = false;
+	return true;
+}
@@ -0,0 +1,47 @@
+#ifndef INDEXSCANNER_H
+#define INDEXSCANNER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QAtomicInt>
+
+#include "FrameIndex.h"
+
+/*!
+*	@brief Thread used to build the packets index of a video in background
+*
+*	Thread used to build the packets index of a video in background, so
+*	opening a video never waits for a pass over the whole file.
+*	Until the index is ready the decoders estimate the number of frames from
+*	the duration and the frame rate, and approximate the seeks; once taken,
+*	the index gives them the exact number of frames, the timestamp of each
+*	frame and the keyframes to seek to.
+*	The index is also stored in its sidecar file, so the scan runs only the
+*	first time a video is opened. A scan in progress is stopped between two
+*	packet reads when another video is opened or the scanner is destroyed.
+*/
+class IndexScanner : public QThread
+{
+	QString			_fileName;		//!< video to scan
+	int				_stream;		//!< index of the video stream
+	QAtomicInt		_abort;			//!< stop the scan in progress
+
+	QMutex			_mutex;			//!< protects all the variables below
+	FrameIndex		_index;			//!< index built
+	bool			_ready;			//!< the index is built and not taken yet
+
+protected:
+	void run();
+
+public:
+
+	IndexScanner();
+	~IndexScanner();
+
+	//  Scan actions
+	void	scan(const QString fileName, const int streamIndex);
+	void	clear();
+	bool	take(FrameIndex &index);
+};
+
+#endif // INDEXSCANNER_H
@@ -31,6 +31,7 @@ MarkersWidget::MarkersWidget(
 	connect(this, SIGNAL(jumpToFrame(qint64)), mainwin, SLOT(jumpToFrame(qint64)));
 	connect(this, SIGNAL(startBtnToggle(bool)), mainwin, SLOT(changeStartEndBtn(bool)));
 	connect(this, SIGNAL(startBtnToggle(bool)), mainwin, SLOT(changeStartEndBtn(bool)));
+	connect(this, SIGNAL(boundariesChanged(QList<qint64>)), mainwin, SLOT(pinFrames(QList<qint64>)));
 }
 
 /*! \brief Destroyer
@@ -246,6 +247,7 @@ void MarkersWidget::removeMarker(const int row)
 
 	// update UI list
 	_markersList->removeRow(row);
+	notifyBoundaries();
 }
 
 
@@ -425,6 +427,7 @@ void MarkersWidget::printListToUI()
 	for (auto m : _markers) {
 		addMarkerToUIList(QString::number(m._start), QString::number(m._end), m._overlap);
 	}
+	notifyBoundaries();
 }
 
 /*! \brief Sort markers by start value first and end value after
@@ -444,6 +447,7 @@ void MarkersWidget::clearListAndUI()
 {
 	clearUIList();
 	_markers.clear();
+	notifyBoundaries();
 }
 
 /*! \brief Remove all markers from the UI list
@@ -456,6 +460,22 @@ void MarkersWidget::clearUIList()
 		_markersList->removeRow(_markersList->rowCount() - 1);
 }
 
+/*! \brief Signal the markers boundaries
+*
+*	Signal the start and end frames of all markers, so that the frames around
+*	them can be kept in memory
+*/
+void MarkersWidget::notifyBoundaries()
+{
+	QList<qint64> boundaries;
+	for (auto m : _markers) {
+		boundaries.append(m._start);
+		if (m._end > m._start)
+			boundaries.append(m._end);
+	}
+	emit boundariesChanged(boundaries);
+}
+
 
 /***************************************
 ************    GETTERS    *************
@@ -88,10 +88,12 @@ private:
 	void printListToUI();
 	void clearListAndUI();
 	void clearUIList();
+	void notifyBoundaries();
 
 signals:
 	void jumpToFrame(const qint64 num);
 	void startBtnToggle(const bool markerStarted);
+	void boundariesChanged(const QList<qint64> boundaries);
 
 private slots:
 	void sort();
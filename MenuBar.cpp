@@ -40,6 +40,12 @@ MenuBar::MenuBar(QWidget *parent) : QMenuBar(parent)
 	menuVideo->addAction(actionGo_To_Frame);
 	menuVideo->addSeparator();
 	menuVideo->addAction(actionVideo_Info);
+#ifdef PROFILING
+	actionTimings = new QAction("Timings", menuVideo);
+	actionTimings->setCheckable(true);
+	actionTimings->setShortcut(QKeySequence(tr("F12")));
+	menuVideo->addAction(actionTimings);
+#endif
 
 	//	 Markers
 	QMenu* menuMarkers			= new QMenu("Markers", this);
@@ -26,6 +26,9 @@ public:
 	QAction* actionPrevious_Frame;
 	QAction* actionGo_To_Frame;
 	QAction* actionVideo_Info;
+#ifdef PROFILING
+	QAction* actionTimings;
+#endif
 
 	//	 Markers
 	QAction* actionCompare;
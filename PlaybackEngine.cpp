@@ -0,0 +1,275 @@
+#include "PlaybackEngine.h"
+
+/*! \brief Create the engine
+*
+*	Create the engine, the thread is started when a video is opened
+*
+*	@param capacity max number of frames decoded ahead
+*/
+PlaybackEngine::PlaybackEngine(const int capacity) : _capacity(qMax(1, capacity))
+{
+	_clockBase = 0;
+	_frameMs = 0;
+	_dropped = 0;
+	_pending = false;
+	_startNum = 0;
+	_endOfStream = false;
+	_abort = false;
+	_quit = false;
+	_decoder.setBuildIndex(false);
+}
+
+/*! \brief Destroyer
+*
+*	Stop the worker and wait for it
+*/
+PlaybackEngine::~PlaybackEngine()
+{
+	_mutex.lock();
+	_quit = true;
+	_abort = true;
+	_requestCond.wakeAll();
+	_spaceCond.wakeAll();
+	_mutex.unlock();
+
+	wait();
+}
+
+/*! \brief Worker loop
+*
+*	Wait for a playback to start and decode its frames one by one, queueing
+*	them as long as there is room. The playback is abandoned when it's
+*	stopped or a new one starts.
+*/
+void PlaybackEngine::run()
+{
+	forever {
+		_mutex.lock();
+		while (!_pending && !_quit)
+			_requestCond.wait(&_mutex);
+		if (_quit) {
+			_mutex.unlock();
+			return;
+		}
+
+		qint64 num = _startNum;
+		_pending = false;
+		_abort = false;
+		_mutex.unlock();
+
+		_decoderMutex.lock();
+		bool ok = _decoder.isOk() && _decoder.seekFrame(num);
+		while (ok) {
+			// numbered by the decoder: frames it skips or merges don't shift
+			// the numbers of the next ones
+			Frame f;
+			f.num = _decoder.getActualFrameNumber();
+			f.time = _decoder.getFrameTime();
+
+			_mutex.lock();
+			qint64 now = clockTime();
+			bool late = now != -1 && f.time < now - _frameMs;
+			_mutex.unlock();
+
+			// late frames are decoded, the next ones may need them, but
+			// neither converted nor queued
+			if (!late)
+				ok = _decoder.getFrame(f.img, &f.num, &f.time);
+
+			_mutex.lock();
+			if (late) {
+				++_dropped;
+			}
+			else if (ok) {
+				while (!_abort && _queue.size() >= _capacity)
+					_spaceCond.wait(&_mutex);
+				if (!_abort)
+					_queue.enqueue(f);
+			}
+			if (_abort)
+				ok = false;
+			_mutex.unlock();
+
+			if (ok)
+				ok = _decoder.readNextFrame();
+		}
+		_decoderMutex.unlock();
+
+		// nothing more to show unless the playback was stopped
+		_mutex.lock();
+		if (!_abort)
+			_endOfStream = true;
+		_mutex.unlock();
+	}
+}
+
+
+/**************************************
+*********    VIDEO ACTIONS    *********
+***************************************/
+
+/*! \brief open a video.
+*
+*   Open the video with the worker decoder and start the worker if needed.
+*	@param fileName path to the video
+*	@param threading how the codec spreads the decoding over threads
+*	@param threads number of codec threads, 0 = one per core
+*	@return success or not
+*/
+bool PlaybackEngine::open(
+	const QString fileName,
+	const QVideoDecoder::ThreadingMode threading,
+	const int threads
+)
+{
+	stop();
+
+	// wait for the worker to leave the decoder
+	_decoderMutex.lock();
+	_decoder.setThreading(threading, threads);
+	bool ok = _decoder.openFile(fileName) && _decoder.isOk();
+	double frameMs = ok ? _decoder.getFrameMsec() : 0;
+	_decoderMutex.unlock();
+
+	_mutex.lock();
+	_frameMs = frameMs;
+	_mutex.unlock();
+
+	if (!isRunning())
+		start();
+	return ok;
+}
+
+/*! \brief set the packets index
+*
+*	Give the packets index of the video to the worker decoder, e.g. once it
+*	has been built in background, so the played frames are numbered as the
+*	ones of the buffer. Waits for the worker to leave the decoder: meant to
+*	be called while the playback is stopped.
+*	@param index the index, the one of the buffer
+*	@return the decoder has the index or not
+*/
+bool PlaybackEngine::setIndex(const FrameIndex &index)
+{
+	QMutexLocker locker(&_decoderMutex);
+	return _decoder.hasIndex() || _decoder.setIndex(index);
+}
+
+/*! \brief start the playback
+*
+*	Start decoding from the given frame, the playback in progress (if any)
+*	is abandoned. The clock starts when the first frame is taken.
+*	@param from first frame number
+*/
+void PlaybackEngine::play(const qint64 from)
+{
+	QMutexLocker locker(&_mutex);
+
+	_queue.clear();
+	_clock.invalidate();
+	_dropped = 0;
+	_endOfStream = false;
+	_startNum = from;
+	_pending = true;
+	_abort = true;
+	_requestCond.wakeOne();
+	_spaceCond.wakeAll();
+}
+
+/*! \brief stop the playback
+*
+*	Abandon the playback in progress and drop the frames not shown yet
+*/
+void PlaybackEngine::stop()
+{
+	QMutexLocker locker(&_mutex);
+
+	_pending = false;
+	_abort = true;
+	_queue.clear();
+	_clock.invalidate();
+	_spaceCond.wakeAll();
+}
+
+
+/**************************************
+*********    FRAME ACTIONS    *********
+***************************************/
+
+/*! \brief take the frame to show now
+*
+*	Take the last frame whose time has been reached by the clock, the older
+*	ones are dropped. The first call with a frame ready starts the clock at
+*	the time of that frame.
+*	@param f where the frame will be stored
+*	@param wait where it stores the ms to wait before calling again
+*	@return a frame must be shown or not
+*/
+bool PlaybackEngine::takeDueFrame(Frame &f, int &wait)
+{
+	QMutexLocker locker(&_mutex);
+
+	wait = PLAYBACK_POLL_MS;
+	if (_queue.isEmpty())
+		return false;
+
+	if (!_clock.isValid()) {
+		_clockBase = _queue.head().time;
+		_clock.start();
+	}
+	qint64 now = clockTime();
+
+	bool due = false;
+	while (!_queue.isEmpty() && _queue.head().time <= now) {
+		if (due)
+			++_dropped;
+		f = _queue.dequeue();
+		due = true;
+	}
+	if (due)
+		_spaceCond.wakeAll();
+
+	if (!_queue.isEmpty())
+		wait = (int) qBound((qint64) 0, _queue.head().time - now, (qint64) 1000);
+	return due;
+}
+
+
+/**************************************
+*********        GETTERS      *********
+***************************************/
+
+/*! \brief the playback reached the end?
+*
+*	The worker decoded the last frame and all the frames have been taken
+*/
+bool PlaybackEngine::isEndOfStream()
+{
+	QMutexLocker locker(&_mutex);
+	return _endOfStream && _queue.isEmpty();
+}
+
+/*! \brief Get dropped frames
+*
+*	Retrieve the number of frames not shown since the playback started
+*/
+qint64 PlaybackEngine::getDroppedFrames()
+{
+	QMutexLocker locker(&_mutex);
+	return _dropped;
+}
+
+
+/**************************************
+************    HELPERS    ************
+***************************************/
+
+/*! \brief playback clock
+*
+*	Current time of the playback, must be called with the mutex locked.
+*	@return time in milliseconds, -1 before the first frame is shown
+*/
+qint64 PlaybackEngine::clockTime()
+{
+	return _clock.isValid() ? _clockBase + _clock.elapsed() : -1;
+}
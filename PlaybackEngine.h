@@ -0,0 +1,80 @@
+#ifndef PLAYBACKENGINE_H
+#define PLAYBACKENGINE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QQueue>
+
+#include "QVideoDecoder.h"
+#include "Frame.h"
+
+#define PLAYBACK_QUEUE_SIZE	8	// frames decoded ahead of the presentation
+#define PLAYBACK_POLL_MS	5	// wait when no frame is ready
+
+/*!
+*	@brief Thread used to decode the frames of the playback
+*
+*	Thread used to decode the frames of the playback.
+*	It owns its own QVideoDecoder and decodes sequentially from the frame the
+*	playback starts at into a bounded queue, waiting when the queue is full.
+*	The GUI thread takes the frames when they are due: the playback clock is
+*	a monotonic timer started with the first frame, and each frame is shown
+*	when the clock reaches its time. When the decoder can't keep up frames
+*	are dropped instead of slowing down the playback: frames already late
+*	are not converted to RGB nor queued, and of the queued frames that are
+*	due together only the last one is shown.
+*/
+class PlaybackEngine : public QThread
+{
+	QVideoDecoder	_decoder;		//!< ffmpeg decoder used only by the worker
+	QMutex			_decoderMutex;	//!< held by the worker while using the decoder
+
+	QMutex			_mutex;			//!< protects all the variables below
+	QWaitCondition	_requestCond;	//!< playback started or thread stopped
+	QWaitCondition	_spaceCond;		//!< a frame left the queue
+
+	QQueue<Frame>	_queue;			//!< frames ready to be shown
+	int				_capacity;		//!< max number of ready frames
+	QElapsedTimer	_clock;			//!< running since the first frame was shown
+	qint64			_clockBase;		//!< time of the first frame shown
+	double			_frameMs;		//!< ms of a single frame
+	qint64			_dropped;		//!< frames not shown since play()
+
+	bool			_pending;		//!< a playback is waiting to be started
+	qint64			_startNum;		//!< first frame of the pending playback
+	bool			_endOfStream;	//!< the worker reached the last frame
+	bool			_abort;			//!< stop the playback in progress
+	bool			_quit;			//!< stop the thread
+
+	//  Helpers
+	qint64 clockTime();
+
+protected:
+	void run();
+
+public:
+
+	PlaybackEngine(const int capacity = PLAYBACK_QUEUE_SIZE);
+	~PlaybackEngine();
+
+	//  Video actions
+	bool open(
+		const QString fileName,
+		const QVideoDecoder::ThreadingMode threading = QVideoDecoder::ThreadingAuto,
+		const int threads = 0
+	);
+	bool setIndex(const FrameIndex &index);
+	void play(const qint64 from);
+	void stop();
+
+	//  Frame actions
+	bool takeDueFrame(Frame &f, int &wait);
+
+	//  Getters
+	bool	isEndOfStream();
+	qint64	getDroppedFrames();
+};
+
+#endif // PLAYBACKENGINE_H
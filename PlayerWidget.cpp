@@ -24,15 +24,31 @@ PlayerWidget::PlayerWidget(
 {
 	playState = false;
 
+	_engine = new PlaybackEngine();
+
+	// fired when the next frame is due, precise so 60 fps don't drift
 	playbackTimer = new QTimer(this);
+	playbackTimer->setSingleShot(true);
+	playbackTimer->setTimerType(Qt::PreciseTimer);
 	connect(playbackTimer, SIGNAL(timeout()), this, SLOT(updateFrame()));
 
+	// checks the seek in progress, if any
+	_seekTicket = 0;
+	seekTimer = new QTimer(this);
+	seekTimer->setSingleShot(true);
+	connect(seekTimer, SIGNAL(timeout()), this, SLOT(updateSeek()));
+
 	// S&S to mainwin
-	connect(this, SIGNAL(newFrame(QPixmap)), mainwin, SLOT(updateFrame(QPixmap)));
+	connect(this, SIGNAL(newFrame(Frame)), mainwin, SLOT(updateFrame(Frame)));
 	connect(this, SIGNAL(timeChanged(qint64)), mainwin, SLOT(updateTime(qint64)));
 	connect(this, SIGNAL(playPauseToggle(bool)), mainwin, SLOT(changePlayPause(bool)));
 	connect(this, SIGNAL(frameChanged()), mainwin, SLOT(updateSlider()));
 	connect(this, SIGNAL(endOfStream()), mainwin, SLOT(endOfStream()));
+	connect(this, SIGNAL(seekFinished()), mainwin, SLOT(seekFinished()));
+	connect(this, SIGNAL(indexChanged()), mainwin, SLOT(indexChanged()));
+
+	// the frames are renumbered when the index built in background is ready
+	connect(_bmng->getIndexScanner(), SIGNAL(finished()), this, SLOT(updateIndex()));
 }
 
 /*! \brief Destroyer
@@ -40,7 +56,9 @@ PlayerWidget::PlayerWidget(
 *	Destroyer
 */
 PlayerWidget::~PlayerWidget()
-{}
+{
+	delete _engine;
+}
 
 /*! \brief display last loaded frame.
 *
@@ -51,23 +69,96 @@ void PlayerWidget::displayFrame()
 	if (!_bmng->isVideoLoaded())
 		return;
 
-	emit newFrame(_actualFrame.img);
+	emit newFrame(_actualFrame);
 	emit timeChanged(_actualFrame.time);
 }
 
-/*! \brief load and display the next frame
+/*! \brief display the frame that is due
 *
-*   Load and display the next frame and emit the signal frameChanged()
+*   Display the frame the playback clock has reached, if any, emit the
+*	signal frameChanged() and wait for the next one.
 */
 void PlayerWidget::updateFrame()
 {
-	if (!nextSingleFrame()) {
+	int wait;
+
+	if (_engine->takeDueFrame(_actualFrame, wait)) {
+		displayFrame();
+		emit frameChanged();
+	}
+	else if (_engine->isEndOfStream()) {
 		stopVideo(false);
 		emit endOfStream();
+		return;
 	}
-	emit frameChanged();
+	playbackTimer->start(wait);
 }
 
+/*! \brief display the result of the seek in progress
+*
+*   Display the preview or the frame of the seek in progress, if ready, and
+*	check again later until the frame arrives. Emit seekFinished() at the end.
+*/
+void PlayerWidget::updateSeek()
+{
+	Frame f;
+	SeekState state = _bmng->takeRequestedFrame(_seekTicket, f);
+
+	if (state == SeekPreview || state == SeekExact) {
+		_actualFrame = f;
+		displayFrame();
+		emit frameChanged();
+	}
+
+	switch (state) {
+	case SeekPending:
+	case SeekPreview:
+		seekTimer->start(SEEKER_POLL_MS);
+		return;
+	case SeekFailed:
+		QMessageBox::critical(NULL, "Error", "seekToFrame failed");
+		break;
+	default:
+		break;
+	}
+	emit seekFinished();
+}
+
+
+/*! \brief renumber the frames with the packets index
+*
+*   Give the decoders the index built in background and find the current
+*	frame again by its time, its predicted number may point to another
+*	frame now. The playback restarts from there, the frames it had queued
+*	have the predicted numbers. Emit indexChanged() when the frame numbers
+*	are final, so the frame count and the markers are refreshed.
+*/
+void PlayerWidget::updateIndex()
+{
+	if (!_bmng->isVideoLoaded())
+		return;
+
+	if (_bmng->takeIndexUpdate()) {
+		if (playState) {
+			playbackTimer->stop();
+			_engine->stop();
+		}
+		_engine->setIndex(_bmng->getIndex());
+
+		if (_actualFrame.num >= 0 && _bmng->getFrameByTime(_actualFrame, _actualFrame.time))
+			displayFrame();
+
+		if (playState) {
+			_engine->play(_actualFrame.num + 1);
+			playbackTimer->start(0);
+		}
+		emit frameChanged();
+	}
+
+	// the scan may also have failed or been stopped
+	if (!_bmng->isIndexPending())
+		emit indexChanged();
+}
 
 /******************* PUBLIC METHODS ************/
 
@@ -188,6 +279,19 @@ void PlayerWidget::seekToTimePercentage(const double perc){
 	return;
 }
 
+/*! \brief seek to given time percentage without waiting
+*
+*	Ask for the frame near the given percentage of the entire video length
+*	and return at once, the frame is displayed by updateSeek() when ready.
+*	A newer request cancels this one.
+*
+*   @param perc double value from 0 to 1
+*/
+void PlayerWidget::requestSeekToTimePercentage(const double perc){
+	_seekTicket = _bmng->requestFrameByTimePercentage(perc);
+	updateSeek();
+}
+
 
 /***************************************
  *********    VIDEO ACTIONS    *********
@@ -208,11 +312,14 @@ void PlayerWidget::loadVideo(const QString fileName)
 
 	// Retrieve datas
 	frameMs		= _bmng->getFrameMsec();
-	numFrames	= _bmng->getNumFrames();
-	videoLength = _bmng->getVideoLengthMs();
 
 	_bmng->getMidFrame(_actualFrame);
 
+	// The playback decodes on its own copy of the video
+	if (!_engine->open(fileName)) {
+		qDebug() << "Playback not available";
+	}
+
 	displayFrame();
 }
 
@@ -240,7 +347,8 @@ void PlayerWidget::playPause()
 
 /*! \brief play the video.
 *
-*	Play the video by starting the timer.
+*	Play the video from the frame after the current one: the engine starts
+*	decoding and the timer shows the frames when they are due.
 *   @see pauseVideo()
 *   @see stopVideo()
 */
@@ -248,13 +356,17 @@ bool PlayerWidget::playVideo()
 {
 	if (!_bmng->isVideoLoaded())
 		return false;
-	playbackTimer->start(frameMs);
+
+	// the index may have been built in background after the video was opened
+	_engine->setIndex(_bmng->getIndex());
+	_engine->play(_actualFrame.num + 1);
+	playbackTimer->start(0);
 	return true;
 }
 
 /*! \brief pause the video.
 *
-*	Pause the video by stopping the timer. 
+*	Pause the video by stopping the timer and the engine. 
 *
 *   @see playVideo()
 *   @see stopVideo()
@@ -265,6 +377,9 @@ bool PlayerWidget::pauseVideo()
 		return false;
 
 	playbackTimer->stop();
+	_engine->stop();
+	if (_engine->getDroppedFrames() > 0)
+		qDebug() << "Playback dropped" << _engine->getDroppedFrames() << "frames";
 
 	// do "another" getFrame because while in playback the buffer isn't updated
 	// (for performance and visualization reason).
@@ -346,10 +461,10 @@ qint64 PlayerWidget::currentFrameTime() {
 
 /*! \brief Get number of frames
 *
-*	Retrieve the number of frames
+*	Retrieve the number of frames, it becomes exact once the video is indexed
 */
 qint64 PlayerWidget::getNumFrames() {
-	return numFrames;
+	return _bmng->getNumFrames();
 }
 
 /*! \brief Percentage of time passed (0 to 1)
@@ -361,5 +476,5 @@ qint64 PlayerWidget::getNumFrames() {
 *   @see currentFrameTime()
 */
 double PlayerWidget::currentTimePercentage() {
-	return _actualFrame.time / (double)videoLength;
+	return _actualFrame.time / (double)_bmng->getVideoLengthMs();
 }
@@ -3,6 +3,7 @@
 
 #include <QVideoDecoder.h>
 #include <ImagesBuffer.h>
+#include <PlaybackEngine.h>
 #include <QLabel>
 #include <QTimer>
 #include <QPushButton>
@@ -15,6 +16,10 @@
 *	function is not a core requirement of the application. 
 *	All standard functions of video playbacking are present (play, pause, stop)
 *	along with frame functions (seek, prev, next).
+*	During the playback frames come from a PlaybackEngine, which decodes
+*	ahead in its own thread and tells when each frame is due.
+*	Seeks requested while scrubbing don't wait for the decoder: the keyframe
+*	near the frame is shown as soon as it's ready, then the frame itself.
 */
 class PlayerWidget : public QWidget 
 {
@@ -23,14 +28,15 @@ class PlayerWidget : public QWidget
 private:
 
 	QTimer			*playbackTimer;
+	QTimer			*seekTimer;
 	ImagesBuffer	*_bmng;
+	PlaybackEngine	*_engine;
 	Frame			_actualFrame;
+	quint64			_seekTicket;	//!< ticket of the seek in progress
 
 	//	Help variables
 	bool	playState;		//!< playing or paused
 	int		frameMs;		//!< ms of a single frame
-	qint64	numFrames;
-	qint64	videoLength;	//!< ms of the entire video
 
 	void	displayFrame();
 
@@ -50,6 +56,7 @@ public:
 	void seekToFrame(const qint64 num);
 	void seekToTime(const qint64 ms);
 	void seekToTimePercentage(const double perc);
+	void requestSeekToTimePercentage(const double perc);
 
 	//  Video actions
 	void loadVideo(const QString fileName);
@@ -68,13 +75,17 @@ public:
 
 private slots:
 	void updateFrame();
+	void updateSeek();
+	void updateIndex();
 
 signals:
 	void frameChanged();
 	void endOfStream();
-	void newFrame(QPixmap img);
+	void seekFinished();
+	void newFrame(const Frame &f);
 	void timeChanged(qint64 ms);
 	void playPauseToggle(bool playState);
+	void indexChanged();
 
 };
 
@@ -1,8 +1,9 @@
 
-#include <QLabel>
 #include <QMessageBox>
+#include <QHash>
 
 #include "PreviewsWidget.h"
+#include "Profiler.h"
 
 /*! \brief Create and setup the previews widget 
 *
@@ -29,6 +30,11 @@ PreviewsWidget::PreviewsWidget(
 	_frame_margin_w = _frame_margin_h = 10;
 	_mid = 0;
 	_mid_index = 0;
+	_frame_num = 0;
+
+	_fillTimer = new QTimer(this);
+	_fillTimer->setSingleShot(true);
+	connect(_fillTimer, SIGNAL(timeout()), this, SLOT(fillPreviews()));
 
 	// s&s
 	connect(this, SIGNAL(updateProgressText(QString)), mainwin, SLOT(updateProgressText(QString)));
@@ -57,6 +63,7 @@ bool PreviewsWidget::setupPreviews()
 	}
 	_bmng->getDimensions(_frame_ratio);
 	calculateFrameNumber(); 
+	setupTiles();
 	reloadAndDrawPreviews(0);
 	return true;
 }
@@ -70,6 +77,7 @@ void PreviewsWidget::reloadLayout()
 	if (!_bmng->isVideoLoaded())
 		return;
 	calculateFrameNumber(); 
+	setupTiles();
 	reloadAndDrawPreviews(_mid);
 }
 
@@ -80,70 +88,189 @@ void PreviewsWidget::reloadLayout()
 */
 void PreviewsWidget::reloadAndDrawPreviews(const qint64 mid)
 {
-	_frames.clear();
-	emit updateProgressText("Updating previews..");
-	_bmng->getImagesBuffer(_frames, mid, _frame_num);
 	_mid = mid;
 	drawPreviews();
-	emit updateProgressText("");
 }
 
 /*! \brief draw all previews
 *
-*	Draw all previews in the widget
+*	Show in the tiles the frames around the middle one. The thumbnails
+*	already shown are moved to their new tile, the ones the buffer has
+*	ready are shown at once, the others are placeholders filled later.
 */
 void PreviewsWidget::drawPreviews()
 {	
-	clearPreviews(); // clear
+	PROFILE_SCOPE("previews draw");
+
+	// when the centre moves by one most frames are already shown, a tile away
+	QHash<qint64, QImage> shown;
+	for (const Tile &t : _tiles) {
+		if (t.ready && t.num != -1)
+			shown.insert(t.num, t.thumb);
+	}
+
+	bool pending = false;
+	qint64 numFrames = _bmng->getNumFrames();
+	for (int i = 0; i < (int) _tiles.size(); ++i) {
+		Tile &t = _tiles[i];
+		qint64 num = _mid - _mid_index + i;
+		if (t.ready && t.num == num)
+			continue;
+
+		Frame f;
+		if (shown.contains(num)) {
+			setTile(t, num, shown.value(num));
+		}
+		else if (num < 0 || num >= numFrames) {
+			setEmpty(t);
+		}
+		else if (_bmng->getThumbnail(f, num, false)) {
+			setTile(t, num, f.img);
+		}
+		else {
+			setPlaceholder(t, num);
+			pending = true;
+		}
+	}
+
+	if (pending) {
+		emit updateProgressText("Updating previews..");
+		_fillTimer->start(0);
+	}
+}
+
+/*! \brief fill a placeholder
+*
+*	Decode the thumbnail of a placeholder, the one nearest to the middle,
+*	and come back for the next one once the events have been processed.
+*/
+void PreviewsWidget::fillPreviews()
+{
+	PROFILE_SCOPE("previews fill");
+
+	int i = nextPlaceholder();
+	if (i == -1) {
+		emit updateProgressText("");
+		return;
+	}
+
+	Tile &t = _tiles[i];
+	Frame f;
+	if (_bmng->getThumbnail(f, t.num))
+		setTile(t, t.num, f.img);
+	else
+		setEmpty(t);
+	_fillTimer->start(0);
+}
+
+
+/**************************************
+************    HELPERS    ************
+***************************************/
+
+/*! \brief create the tiles
+*
+*	Create a tile for each preview, the ones of the previous layout are
+*	deleted. The tiles of the same layout are reused for all the frames.
+*/
+void PreviewsWidget::setupTiles()
+{
+	_fillTimer->stop();
+	clearPreviews();
+	_tiles.clear();
 
-	// draw
 	for (int i = 0; i < _frame_num; ++i) {
-		// init layout and widgets
-		QWidget *prew = new QWidget();
+		Tile t;
+		t.widget = new QWidget();
 		QVBoxLayout *l = new QVBoxLayout();
 		l->setSpacing(0);
 		l->setMargin(0);
 		l->setAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
 
-		QLabel *img = new QLabel();
-		l->addWidget(img);
+		t.img = new VideoSurface();
+		t.img->setFixedSize(_frame_w, _frame_h);
+		l->addWidget(t.img);
+
+		t.lbl = new QLabel();
+		t.lbl->setFixedHeight(18);
+		t.lbl->setStyleSheet("border:none;");
+		l->addWidget(t.lbl);
+
 		if (i == _mid_index)
-			prew->setStyleSheet("border-bottom:5px solid #005fb3;");
-		img->setStyleSheet("border:none;");
-			// prew->setStyleSheet("background-color:#005fb3;");
-		// img->setMinimumSize(1, 1);
-
-		// if it's a valid frame
-		if (i < _frames.size()) {
-			if (_frames[i].num != -1) {
-				// draw the img
-				img->setPixmap(
-					_frames[i].img.scaled(
-						_frame_w, _frame_h,
-						Qt::KeepAspectRatio, Qt::SmoothTransformation
-					)
-				);
-				// write frame number
-				QLabel *lbl = new QLabel(QString::number(_frames[i].num));
-				lbl->setFixedHeight(18);
-				lbl->setStyleSheet("border:none;");
-				l->addWidget(lbl);
-			}
-			else {
-				img->setText("");
-			}
-		}
-		else {
-			img->setText("Buffer not big enough");
-			img->setWordWrap(true);
-		}
+			t.widget->setStyleSheet("border-bottom:5px solid #005fb3;");
 
-		// connect all elements
-		prew->setLayout(l);
-		_base->addWidget(prew);
+		t.num = -1;
+		t.ready = false;
+		t.widget->setLayout(l);
+		_base->addWidget(t.widget);
+		_tiles.push_back(t);
 	}
 }
 
+/*! \brief show a thumbnail
+*
+*	Show the thumbnail of a frame in a tile
+*	@param t the tile
+*	@param num frame number
+*	@param thumb thumbnail, already of the right size
+*/
+void PreviewsWidget::setTile(Tile &t, const qint64 num, const QImage &thumb)
+{
+	if (t.num != num)
+		t.lbl->setText(QString::number(num));
+	t.num = num;
+	t.ready = true;
+	t.thumb = thumb;
+	t.img->setFrame(thumb);
+}
+
+/*! \brief show a placeholder
+*
+*	Show a placeholder in a tile, until its thumbnail is decoded
+*	@param t the tile
+*	@param num frame number
+*/
+void PreviewsWidget::setPlaceholder(Tile &t, const qint64 num)
+{
+	if (t.num != num)
+		t.lbl->setText(QString::number(num));
+	t.num = num;
+	t.ready = false;
+	t.thumb = QImage();
+	t.img->setText("..");
+}
+
+/*! \brief empty a tile
+*
+*	Show nothing in a tile, out of the video
+*	@param t the tile
+*/
+void PreviewsWidget::setEmpty(Tile &t)
+{
+	t.num = -1;
+	t.ready = true;
+	t.thumb = QImage();
+	t.img->clear();
+	t.lbl->clear();
+}
+
+/*! \brief find the next placeholder
+*
+*	Find the placeholder nearest to the middle tile
+*	@return tile index, -1 if there are no placeholders
+*/
+int PreviewsWidget::nextPlaceholder()
+{
+	for (int d = 0; d < (int) _tiles.size(); ++d) {
+		int i = _mid_index - d;
+		if (i >= 0 && i < (int) _tiles.size() && !_tiles[i].ready)
+			return i;
+		i = _mid_index + d;
+		if (i >= 0 && i < (int) _tiles.size() && !_tiles[i].ready)
+			return i;
+	}
+	return -1;
+}
 
 /*! \brief clear the layout
 *
@@ -184,5 +311,8 @@ void PreviewsWidget::calculateFrameNumber()
 	_frame_w   = _frame_ratio * _frame_h; // frame w based on original frame ratio
 	_frame_num = width() / (_frame_w + _frame_margin_w * 2);
 	_mid_index = (_frame_num - 1) / 2;
+
+	// previews are decoded directly at their size
+	_bmng->setThumbnailSize(QSize(_frame_w, _frame_h));
 }
 
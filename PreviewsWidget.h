@@ -3,7 +3,10 @@
 
 #include <QWidget>
 #include <QHBoxLayout>
+#include <QLabel>
+#include <QTimer>
 #include <ImagesBuffer.h>
+#include <VideoSurface.h>
 
 /*!
 *	@brief Class used to display previews of the loaded video
@@ -12,12 +15,27 @@
 *	The number of previews is calculated based on dimensions of the window, it's
 *	better to DO NOT update the previews while the video is playing because it 
 *	can greatly decrease rendering performance causing lag and stutters.
+*	The tiles are created once for each layout and reused: moving the centre
+*	only changes the images of the tiles, taking the ones already shown when
+*	the frames just shift. The thumbnails not ready at once are shown as
+*	placeholders and decoded one at a time when the event loop is idle, the
+*	nearest to the centre first.
 */
 class PreviewsWidget : public QWidget
 {
 	Q_OBJECT
 
 private:
+	//! Reusable preview
+	struct Tile {
+		QWidget	*widget;
+		VideoSurface *img;
+		QLabel	*lbl;		//!< frame number
+		QImage	thumb;		//!< thumbnail shown, shared with the buffer
+		qint64	num;		//!< frame shown, -1 = none
+		bool	ready;		//!< the thumbnail is shown, not a placeholder
+	};
+
 	int		_frame_num;
 	int		_frame_w;
 	int		_frame_h;
@@ -28,12 +46,18 @@ private:
 	int		_mid_index;			//!< mid frame inex
 
 	ImagesBuffer *_bmng;
-	std::vector<Frame> _frames;
+	std::vector<Tile> _tiles;
 	QHBoxLayout *_base;
+	QTimer	*_fillTimer;		//!< decodes the placeholders when idle
 
 	void calculateFrameNumber();
 	void clear(QLayout* layout);
 	void drawPreviews();
+	void setupTiles();
+	void setTile(Tile &t, const qint64 num, const QImage &thumb);
+	void setPlaceholder(Tile &t, const qint64 num);
+	void setEmpty(Tile &t);
+	int  nextPlaceholder();
 
 public:
 	explicit PreviewsWidget(QWidget *parent = 0, QWidget *mainwin = 0, ImagesBuffer *buff = 0);
@@ -44,6 +68,9 @@ public:
 	bool setupPreviews();
 	void clearPreviews();
 
+private slots:
+	void fillPreviews();
+
 signals:
 	void updateProgressText(QString);
 };
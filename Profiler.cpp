@@ -0,0 +1,344 @@
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <algorithm>
+
+#include "Profiler.h"
+
+thread_local Profiler::ThreadOwner Profiler::_owner;
+
+/*! \brief Create the profiler
+*
+*	Create a profiler without probes, use instance()
+*/
+Profiler::Profiler()
+{}
+
+/*! \brief The profiler
+*
+*	The profiler of the application, created at the first use
+*/
+Profiler &Profiler::instance()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+/*! \brief Default path of the json dump
+*
+*	Path of the json dump in the cache folder of the application
+*/
+QString Profiler::defaultDumpPath()
+{
+	QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+	QDir().mkpath(dir);
+	return dir + "/profile.json";
+}
+
+
+/**************************************
+********    PROFILER ACTIONS    *******
+***************************************/
+
+/*! \brief Get a probe
+*
+*	Get the probe with the given name, creating it the first time. Timers
+*	with the same name in different places add to the same probe.
+*	@param name name of the probe
+*	@return id of the probe
+*/
+int Profiler::probe(const char *name)
+{
+	QMutexLocker locker(&_mutex);
+
+	for (int i = 0; i < (int) _names.size(); ++i) {
+		if (_names[i] == name)
+			return i;
+	}
+	if (_names.size() >= PROFILER_MAX_PROBES)
+		return -1;
+
+	Probe p;
+	p.name = name;
+	p.count = p.total = p.max = 0;
+	std::fill(p.buckets, p.buckets + PROFILER_BUCKETS, 0);
+	_names.push_back(p.name);
+	_ended.push_back(p);
+	return _names.size() - 1;
+}
+
+/*! \brief Record a time
+*
+*	Add a time to a probe, in the counters of the current thread. Only this
+*	thread writes them, so no lock is taken.
+*	@param id id of the probe, given by probe(); -1 is ignored
+*	@param ns time in ns
+*/
+void Profiler::record(const int id, const qint64 ns)
+{
+	if (id < 0 || id >= PROFILER_MAX_PROBES)
+		return;
+
+	ThreadTimes *times = threadTimes();
+	ThreadProbe *t = times->probes[id].load(std::memory_order_relaxed);
+	if (!t) {
+		t = new ThreadProbe();
+		times->probes[id].store(t, std::memory_order_release);
+	}
+
+	// plain loads and stores, the reports only read
+	const qint64 n = t->count.load(std::memory_order_relaxed);
+	t->window[n % PROFILER_WINDOW].store(ns, std::memory_order_relaxed);
+	t->total.store(t->total.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+	if (ns > t->max.load(std::memory_order_relaxed))
+		t->max.store(ns, std::memory_order_relaxed);
+	std::atomic<qint64> &b = t->buckets[bucket(ns)];
+	b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	t->count.store(n + 1, std::memory_order_release);
+}
+
+
+/**************************************
+*********    THREAD TIMES    **********
+***************************************/
+
+/*! \brief Create the counters of a probe
+*
+*	Create the counters of a probe in a thread, without times
+*/
+Profiler::ThreadProbe::ThreadProbe()
+{
+	count.store(0);
+	total.store(0);
+	max.store(0);
+	for (std::atomic<qint64> &b : buckets)
+		b.store(0);
+	for (std::atomic<qint64> &ns : window)
+		ns.store(0);
+}
+
+/*! \brief Create the times of a thread
+*
+*	Create the times of a thread, without probes
+*/
+Profiler::ThreadTimes::ThreadTimes()
+{
+	for (std::atomic<ThreadProbe *> &p : probes)
+		p.store(0);
+}
+
+/*! \brief Destroyer
+*
+*	Destroy the counters of the probes
+*/
+Profiler::ThreadTimes::~ThreadTimes()
+{
+	for (std::atomic<ThreadProbe *> &p : probes)
+		delete p.load();
+}
+
+/*! \brief Destroyer
+*
+*	The thread is ending: hand its times to the profiler
+*/
+Profiler::ThreadOwner::~ThreadOwner()
+{
+	if (times)
+		Profiler::instance().endThread(times);
+}
+
+
+/**************************************
+*********        REPORTS      *********
+***************************************/
+
+/*! \brief Summary of the last times
+*
+*	A line for each probe with its count, and mean, p50, p95 and max of its
+*	last times, in ms
+*/
+QString Profiler::summary()
+{
+	QMutexLocker locker(&_mutex);
+	const std::vector<Probe> merged = merge();
+
+	QString s = QString("%1 %2 %3 %4 %5 %6")
+		.arg("probe", -12).arg("count", 8).arg("mean", 8).arg("p50", 8).arg("p95", 8).arg("max", 8);
+	for (const Probe &p : merged) {
+		if (p.window.empty())
+			continue;
+
+		qint64 sum = 0, max = 0;
+		for (qint64 ns : p.window) {
+			sum += ns;
+			max = qMax(max, ns);
+		}
+		qint64 p50, p95;
+		percentiles(p.window, p50, p95);
+
+		s += QString("\n%1 %2 %3 %4 %5 %6")
+			.arg(p.name, -12).arg(p.count, 8)
+			.arg(sum / 1e6 / p.window.size(), 8, 'f', 2)
+			.arg(p50 / 1e6, 8, 'f', 2).arg(p95 / 1e6, 8, 'f', 2).arg(max / 1e6, 8, 'f', 2);
+	}
+	return s;
+}
+
+/*! \brief Dump the times as json
+*
+*	Write all the probes: totals since the start, histogram and percentiles
+*	of the last times. Times are in us.
+*	@param fileName path of the json file
+*	@return success or not
+*/
+bool Profiler::dump(const QString &fileName)
+{
+	QJsonArray probes;
+	_mutex.lock();
+	const std::vector<Probe> merged = merge();
+	_mutex.unlock();
+
+	for (const Probe &p : merged) {
+		QJsonObject o;
+		o["name"] = p.name;
+		o["count"] = (double) p.count;
+		o["total_us"] = p.total / 1e3;
+		o["mean_us"] = p.count ? p.total / 1e3 / p.count : 0.0;
+		o["max_us"] = p.max / 1e3;
+
+		qint64 p50 = 0, p95 = 0;
+		if (!p.window.empty())
+			percentiles(p.window, p50, p95);
+		o["window"] = (int) p.window.size();
+		o["window_p50_us"] = p50 / 1e3;
+		o["window_p95_us"] = p95 / 1e3;
+
+		// bucket i holds the times in [2^i, 2^(i+1)) us, the first one below 2 us
+		QJsonArray buckets;
+		for (qint64 n : p.buckets)
+			buckets.append((double) n);
+		o["histogram_log2_us"] = buckets;
+		probes.append(o);
+	}
+
+	QJsonObject root;
+	root["probes"] = probes;
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+	QByteArray json = QJsonDocument(root).toJson();
+	return file.write(json) == json.size();
+}
+
+
+/**************************************
+************    HELPERS    ************
+***************************************/
+
+/*! \brief Times of the current thread
+*
+*	Counters of the current thread, created and registered at its first time
+*/
+Profiler::ThreadTimes *Profiler::threadTimes()
+{
+	if (!_owner.times) {
+		ThreadTimes *times = new ThreadTimes();
+		QMutexLocker locker(&_mutex);
+		_threads.push_back(times);
+		_owner.times = times;
+	}
+	return _owner.times;
+}
+
+/*! \brief A thread has ended
+*
+*	Keep the times of a thread that has ended and drop its counters
+*	@param times counters of the thread
+*/
+void Profiler::endThread(ThreadTimes *times)
+{
+	QMutexLocker locker(&_mutex);
+
+	for (int id = 0; id < (int) _ended.size(); ++id) {
+		const ThreadProbe *t = times->probes[id].load();
+		if (!t)
+			continue;
+
+		Probe &p = _ended[id];
+		addTimes(p, *t);
+		if (p.window.size() > PROFILER_WINDOW)
+			p.window.erase(p.window.begin(), p.window.end() - PROFILER_WINDOW);
+	}
+	_threads.erase(std::find(_threads.begin(), _threads.end(), times));
+	delete times;
+}
+
+/*! \brief Times of all the threads
+*
+*	Add up the times of the ended threads and the current counters of the
+*	running ones, to be called with the mutex locked
+*	@return the times of each probe
+*/
+std::vector<Profiler::Probe> Profiler::merge()
+{
+	std::vector<Probe> probes = _ended;
+	for (const ThreadTimes *times : _threads) {
+		for (int id = 0; id < (int) probes.size(); ++id) {
+			if (const ThreadProbe *t = times->probes[id].load(std::memory_order_acquire))
+				addTimes(probes[id], *t);
+		}
+	}
+	return probes;
+}
+
+/*! \brief Add the times of a thread
+*
+*	Add the counters of a probe in a thread to the probe, and its last times
+*	to the window
+*	@param p probe
+*	@param t counters of the probe in a thread
+*/
+void Profiler::addTimes(Probe &p, const ThreadProbe &t)
+{
+	const qint64 count = t.count.load(std::memory_order_acquire);
+	p.count += count;
+	p.total += t.total.load(std::memory_order_relaxed);
+	p.max = qMax(p.max, t.max.load(std::memory_order_relaxed));
+	for (int b = 0; b < PROFILER_BUCKETS; ++b)
+		p.buckets[b] += t.buckets[b].load(std::memory_order_relaxed);
+
+	// oldest first
+	for (qint64 n = qMax(count - PROFILER_WINDOW, (qint64) 0); n < count; ++n)
+		p.window.push_back(t.window[n % PROFILER_WINDOW].load(std::memory_order_relaxed));
+}
+
+/*! \brief Bucket of a time
+*
+*	Histogram bucket of a time, a power of 2 of us
+*	@param ns time in ns
+*/
+int Profiler::bucket(const qint64 ns)
+{
+	int b = 0;
+	for (qint64 us = ns / 1000; us > 1 && b < PROFILER_BUCKETS - 1; us >>= 1)
+		++b;
+	return b;
+}
+
+/*! \brief Percentiles of the last times
+*
+*	p50 and p95 (nearest rank) of the window of a probe
+*	@param window last times, not empty, a copy is sorted
+*	@param p50 where the median will be stored
+*	@param p95 where the 95th percentile will be stored
+*/
+void Profiler::percentiles(std::vector<qint64> window, qint64 &p50, qint64 &p95)
+{
+	std::sort(window.begin(), window.end());
+	p50 = window[qMin(window.size() / 2, window.size() - 1)];
+	p95 = window[qMin(window.size() * 95 / 100, window.size() - 1)];
+}
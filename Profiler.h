@@ -0,0 +1,127 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QString>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <vector>
+#include <atomic>
+
+#define PROFILER_WINDOW		512		// last times of each probe and thread the percentiles are computed on
+#define PROFILER_BUCKETS	24		// histogram buckets, powers of 2 of us (1 us .. 8 s)
+#define PROFILER_MAX_PROBES	32		// probes of the application, more aren't recorded
+
+/*!
+*	@brief Class used to time the hot paths
+*
+*	Class used to time the hot paths (demuxing, decoding, colour conversion,
+*	buffer filling, painting) with scoped timers, see PROFILE_SCOPE.
+*	Each probe keeps, since the start, its count, total and max time and a
+*	histogram with a bucket for each power of 2 of microseconds, and a
+*	rolling window of the last times of each thread, on which the
+*	percentiles are computed.
+*	Probes are timed on any thread without locks: every thread records in
+*	its own counters, which only the reports read and add up under the
+*	mutex, so the decoding threads are never serialized by their timers.
+*	Nothing is allocated after the first time of a probe in a thread; the
+*	times of a thread are kept when it ends.
+*	The summary of the last times is shown by the ProfilerOverlay, and
+*	everything is dumped as json when the application exits.
+*/
+class Profiler
+{
+	//! Times of a probe, added up from all the threads
+	struct Probe {
+		QString					name;
+		qint64					count;
+		qint64					total;		//!< ns
+		qint64					max;		//!< ns
+		qint64					buckets[PROFILER_BUCKETS];
+		std::vector<qint64>		window;		//!< last times, ns
+	};
+
+	//! Times of a probe in a thread, written only by that thread
+	struct ThreadProbe {
+		std::atomic<qint64>		count;
+		std::atomic<qint64>		total;		//!< ns
+		std::atomic<qint64>		max;		//!< ns
+		std::atomic<qint64>		buckets[PROFILER_BUCKETS];
+		std::atomic<qint64>		window[PROFILER_WINDOW];	//!< last times, the count-th one at count % PROFILER_WINDOW
+
+		ThreadProbe();
+	};
+
+	//! Probes timed by a thread
+	struct ThreadTimes {
+		std::atomic<ThreadProbe *>	probes[PROFILER_MAX_PROBES];	//!< created at their first time
+
+		ThreadTimes();
+		~ThreadTimes();
+	};
+
+	//! Hands the times of the current thread to the profiler when the thread ends
+	struct ThreadOwner {
+		ThreadTimes				*times = 0;
+		~ThreadOwner();
+	};
+
+	static thread_local ThreadOwner	_owner;
+
+	QMutex						_mutex;		//!< protects all the variables below
+	std::vector<QString>		_names;		//!< name of each probe id
+	std::vector<ThreadTimes *>	_threads;	//!< times of the running threads
+	std::vector<Probe>			_ended;		//!< times of the threads already ended, by probe id
+
+	Profiler();
+
+	//  Helpers
+	ThreadTimes	*threadTimes();
+	void		endThread(ThreadTimes *times);
+	std::vector<Probe>	merge();
+	static void	addTimes(Probe &p, const ThreadProbe &t);
+	static int	bucket(const qint64 ns);
+	static void	percentiles(std::vector<qint64> window, qint64 &p50, qint64 &p95);
+
+public:
+
+	static Profiler &instance();
+
+	//  Profiler actions
+	int		probe(const char *name);
+	void	record(const int id, const qint64 ns);
+
+	//  Reports
+	QString	summary();
+	bool	dump(const QString &fileName);
+
+	static QString defaultDumpPath();
+};
+
+/*!
+*	@brief Scoped timer of a probe
+*
+*	Times its own lifetime and records it in the Profiler, see PROFILE_SCOPE
+*/
+class ProfileScope
+{
+	int				_id;
+	QElapsedTimer	_timer;
+
+public:
+	ProfileScope(const int id) : _id(id) { _timer.start(); }
+	~ProfileScope() { Profiler::instance().record(_id, _timer.nsecsElapsed()); }
+};
+
+// Times the rest of the enclosing scope as the probe "name". It compiles to
+// nothing unless PROFILING is defined (see profiler.pri)
+#ifdef PROFILING
+#define PROFILE_JOIN2(a, b)	a##b
+#define PROFILE_JOIN(a, b)	PROFILE_JOIN2(a, b)
+#define PROFILE_SCOPE(name) \
+	static const int PROFILE_JOIN(_profileId, __LINE__) = Profiler::instance().probe(name); \
+	ProfileScope PROFILE_JOIN(_profileScope, __LINE__)(PROFILE_JOIN(_profileId, __LINE__))
+#else
+#define PROFILE_SCOPE(name)
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,57 @@
+#include <QFontDatabase>
+
+#include "ProfilerOverlay.h"
+#include "Profiler.h"
+
+/*! \brief Create the overlay
+*
+*	Create the overlay, hidden
+*
+*	@param parent widget it's shown over
+*/
+ProfilerOverlay::ProfilerOverlay(QWidget *parent) : QLabel(parent)
+{
+	setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+	setStyleSheet("background-color:rgba(0, 0, 0, 160); color:#fff; padding:4px;");
+	setAttribute(Qt::WA_TransparentForMouseEvents);
+	move(8, 8);
+	hide();
+
+	_refreshTimer = new QTimer(this);
+	connect(_refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+/*! \brief Destroyer
+*
+*	Destroyer
+*/
+ProfilerOverlay::~ProfilerOverlay()
+{}
+
+/*! \brief show or hide the overlay
+*
+*	Show the overlay, refreshing it periodically, or hide it
+*	@param show show or hide
+*/
+void ProfilerOverlay::setShown(const bool show)
+{
+	if (show) {
+		refresh();
+		raise();
+		_refreshTimer->start(PROFILER_OVERLAY_MS);
+	}
+	else {
+		_refreshTimer->stop();
+	}
+	setVisible(show);
+}
+
+/*! \brief refresh the overlay
+*
+*	Show the current summary of the Profiler
+*/
+void ProfilerOverlay::refresh()
+{
+	setText(Profiler::instance().summary());
+	adjustSize();
+}
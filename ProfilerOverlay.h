@@ -0,0 +1,34 @@
+#ifndef PROFILEROVERLAY_H
+#define PROFILEROVERLAY_H
+
+#include <QLabel>
+#include <QTimer>
+
+#define PROFILER_OVERLAY_MS	500		// refresh period of the overlay
+
+/*!
+*	@brief Widget used to show the timings of the hot paths
+*
+*	Widget used to show the timings of the hot paths over the video: a small
+*	translucent panel in the top left corner of its parent, with a line for
+*	each probe of the Profiler, refreshed twice per second while visible.
+*	It doesn't take the mouse events, the widget below keeps working.
+*/
+class ProfilerOverlay : public QLabel
+{
+	Q_OBJECT
+
+	QTimer	*_refreshTimer;
+
+public:
+	explicit ProfilerOverlay(QWidget *parent = 0);
+	~ProfilerOverlay();
+
+public slots:
+	void setShown(const bool show);
+
+private slots:
+	void refresh();
+};
+
+#endif // PROFILEROVERLAY_H
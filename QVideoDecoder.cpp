@@ -42,15 +42,17 @@
 */
 
 #include "QVideoDecoder.h"
+#include "Profiler.h"
 
 #include <stdint.h>
+#include <utility>
 
 
 /*! \brief Constructor
 *
 *   Constructor
 */
-QVideoDecoder::QVideoDecoder()
+QVideoDecoder::QVideoDecoder() : framePool(new FramePool())
 {
 	InitVars();
 	initCodec();
@@ -59,7 +61,7 @@ QVideoDecoder::QVideoDecoder()
 *
 *   Constructor
 */
-QVideoDecoder::QVideoDecoder(const QString file)
+QVideoDecoder::QVideoDecoder(const QString file) : framePool(new FramePool())
 {
 	InitVars();
 	initCodec();
@@ -102,10 +104,107 @@ void QVideoDecoder::InitVars()
 	pCodecCtx=0;
 	pCodec=0;
 	pFrame=0;
-	pFrameRGB=0;
-	buffer=0;
 	img_convert_ctx=0;
 	millisecondbase = { 1, 1000 };
+	strategy = 0;
+	threadingMode = ThreadingAuto;
+	threadCount = 0;
+	outWidth = 0;
+	outHeight = 0;
+	lowres = 0;
+	keyFramesOnly = false;
+	buildIndex = true;
+	chooseMSec = 0;
+}
+
+/*! \brief Set the codec threading
+*
+*   Set how the codec spreads the decoding over threads, used from the next
+*	opened file.
+*	@param mode threading mode
+*	@param count number of threads, 0 lets ffmpeg use one per core
+*/
+void QVideoDecoder::setThreading(const ThreadingMode mode, const int count)
+{
+	threadingMode = mode;
+	threadCount = (count < 0) ? 0 : count;
+}
+
+/*! \brief Set the size of the converted frames
+*
+*   Set the size of the frames returned by getFrame, the conversion scales
+*	them directly. When set before opening a file, codecs that support it
+*	decode at a reduced resolution still not smaller than this size.
+*	@param width frames width, 0 = video width
+*	@param height frames height, 0 = video height
+*/
+void QVideoDecoder::setOutputSize(const int width, const int height)
+{
+	outWidth = (width < 0) ? 0 : width;
+	outHeight = (height < 0) ? 0 : height;
+
+	if (ok) {
+		framePool->setGeometry(getOutputWidth(), getOutputHeight());
+		LastFrameConverted = false;
+	}
+}
+
+/*! \brief Decode keyframes only
+*
+*   Decode only the keyframes, the other packets are read but never given to
+*	the codec: meant for sequential passes over the whole video (e.g. the
+*	filmstrip), seeking to a frame that is not a keyframe gives the next one.
+*	Used from the next opened file.
+*	@param enable keyframes only or all the frames
+*/
+void QVideoDecoder::setKeyFramesOnly(const bool enable)
+{
+	keyFramesOnly = enable;
+}
+
+/*! \brief Build the packets index when opening
+*
+*   When enabled openFile builds the packets index if its sidecar file is
+*	missing, which reads the whole file. When disabled it only loads the
+*	sidecar, the index can be built elsewhere (e.g. in background) and given
+*	later with setIndex() or loadIndex(). Used from the next opened file.
+*	@param enable build the index or only load it
+*/
+void QVideoDecoder::setBuildIndex(const bool enable)
+{
+	buildIndex = enable;
+}
+
+/*! \brief Load the packets index
+*
+*   Load the packets index of the open video from its sidecar file, e.g.
+*	after it has been built in background.
+*	@return success or not
+*/
+bool QVideoDecoder::loadIndex()
+{
+	if (!ok)
+		return false;
+	bool loaded = index.load(path, videoStream);
+	updateTimeline();
+	return loaded;
+}
+
+/*! \brief Set the packets index
+*
+*   Replace the packets index of the open video with the given one, which
+*	must have been built from the same video stream.
+*	@param idx the index
+*	@return success or not
+*/
+bool QVideoDecoder::setIndex(const FrameIndex &idx)
+{
+	FrameIndex copy = idx;
+	if (!ok || !copy.isValid() || copy.stream() != videoStream)
+		return false;
+	index = std::move(copy);
+	updateTimeline();
+	return true;
 }
 
 /*! \brief Close the file and reset all variables
@@ -117,25 +216,26 @@ void QVideoDecoder::close()
 	/*if(!ok)
 		return;*/
 
-	// Free the RGB image
-	if(buffer)
-		delete [] buffer;
-
 	// Free the YUV frame
 	if(pFrame)
 		av_free(pFrame);
-
-	// Free the RGB frame
-	if(pFrameRGB)
-		av_free(pFrameRGB);
+	pFrame=0;
 
 	// Close the codec
 	if(pCodecCtx)
 		avcodec_close(pCodecCtx);
+	pCodecCtx=0;
 
 	// Close the video file
 	if(pFormatCtx)
 		avformat_close_input(&pFormatCtx);
+
+	// Drop the packets index
+	index.clear();
+	timeline.clear();
+
+	delete strategy;
+	strategy = 0;
 }
 
 
@@ -156,6 +256,7 @@ bool QVideoDecoder::openFile(const QString filename)
 	LastFrameNumber = 0;
 	LastIdealFrameNumber = 0;
 	LastFrameOk = false;
+	LastFrameConverted = false;
 
 	// Open video file
 	if(avformat_open_input(&pFormatCtx, filename.toStdString().c_str(), NULL, NULL)!=0)
@@ -187,10 +288,52 @@ bool QVideoDecoder::openFile(const QString filename)
 	if(pCodec==NULL)
 		return false; // Codec not found
 
+	// Spread the decoding over threads, must be set before opening the codec
+	switch (threadingMode) {
+		case ThreadingFrame:
+			pCodecCtx->thread_type = FF_THREAD_FRAME;
+			pCodecCtx->thread_count = threadCount;
+			break;
+		case ThreadingSlice:
+			pCodecCtx->thread_type = FF_THREAD_SLICE;
+			pCodecCtx->thread_count = threadCount;
+			break;
+		case ThreadingNone:
+			pCodecCtx->thread_count = 1;
+			break;
+		default:
+			pCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+			pCodecCtx->thread_count = threadCount;
+	}
+
+	// Full size of the frames, the codec reduces it with lowres
+	w				= pCodecCtx->width;
+	h				= pCodecCtx->height;
+
+	// Decode at reduced resolution when small frames are asked and the codec
+	// can (not many: mpeg 1/2/4, mjpeg, ...), each level halves the size
+	lowres = 0;
+	while (
+		outWidth > 0 && outHeight > 0 && lowres < ffmpeg::av_codec_get_max_lowres(pCodec) &&
+		(w >> (lowres + 1)) >= outWidth && (h >> (lowres + 1)) >= outHeight
+	)
+		++lowres;
+	ffmpeg::av_codec_set_lowres(pCodecCtx, lowres);
+
+	// the codec drops anything but keyframes too, in case a packet is
+	// flagged wrong
+	pCodecCtx->skip_frame = keyFramesOnly ? ffmpeg::AVDISCARD_NONKEY : ffmpeg::AVDISCARD_DEFAULT;
+
 	// Open codec
 	if(avcodec_open2(pCodecCtx, pCodec, NULL)<0)
 		return false; // Could not open codec
 
+	qDebug() << "Decoding threads:" << pCodecCtx->thread_count
+		<< ((pCodecCtx->active_thread_type & FF_THREAD_FRAME) ? "frame" :
+			(pCodecCtx->active_thread_type & FF_THREAD_SLICE) ? "slice" : "none");
+	if (lowres)
+		qDebug() << "Decoding at 1 /" << (1 << lowres) << "of the size";
+
 	// Hack to correct wrong frame rates that seem to be generated by some
 	// codecs
 	if(pCodecCtx->time_base.num>1000 && pCodecCtx->time_base.den==1)
@@ -198,27 +341,20 @@ bool QVideoDecoder::openFile(const QString filename)
 
 	// Allocate video frame
 	pFrame=ffmpeg::avcodec_alloc_frame();
-
-	// Allocate an AVFrame structure
-	pFrameRGB=ffmpeg::avcodec_alloc_frame();
-	if(pFrameRGB==NULL)
+	if(pFrame==NULL)
 		return false;
 
-	// Determine required buffer size and allocate buffer
-	numBytes=ffmpeg::avpicture_get_size(ffmpeg::PIX_FMT_RGB24, pCodecCtx->width,pCodecCtx->height);
-	buffer=new uint8_t[numBytes];
-
-	// Assign appropriate parts of buffer to image planes in pFrameRGB
-	avpicture_fill((ffmpeg::AVPicture *)pFrameRGB, buffer, ffmpeg::PIX_FMT_RGB24,
-		pCodecCtx->width, pCodecCtx->height);
+	// Converted frames are written directly into pooled images
+	framePool->setGeometry(getOutputWidth(), getOutputHeight());
 
 	// Set variables
 	path			= filename;
 	type			= QString(pFormatCtx->iformat->name);
+	strategy		= ContainerStrategy::create(type);
 	duration		= pFormatCtx->duration;
 	baseFrameRate	= av_q2d(pFormatCtx->streams[videoStream]->r_frame_rate);
 	frameMSec		= 1000 / baseFrameRate;
-	if (type == "matroska,webm" || type.indexOf("mp4") != -1) {
+	if (strategy->hasFirstPacketTiming()) {
 		frameMSecReal =
 			(double)(pFormatCtx->streams[videoStream]->time_base.den /
 			pFormatCtx->streams[videoStream]->time_base.num) /
@@ -246,6 +382,7 @@ bool QVideoDecoder::openFile(const QString filename)
 	}
 	else {
 		frameMSecReal = frameMSec;
+		chooseMSec = frameMSec;
 		firstDts = pFormatCtx->streams[videoStream]->first_dts;
 		if (firstDts == AV_NOPTS_VALUE)
 			firstDts = 0;
@@ -256,12 +393,28 @@ bool QVideoDecoder::openFile(const QString filename)
 	baseFRateReal	= 1000 / (double) frameMSecReal;
 	timeBaseRat		= pFormatCtx->streams[videoStream]->time_base;
 	timeBase		= av_q2d(timeBaseRat);
-	w				= pCodecCtx->width;
-	h				= pCodecCtx->height;
+
+	// from now on frame numbers and seeks are up to the container strategy
+	StreamTiming timing;
+	timing.startTs			= startTs;
+	timing.firstDts			= firstDts;
+	timing.frameRate		= baseFrameRate;
+	timing.frameMSec		= frameMSec;
+	timing.frameMSecReal	= frameMSecReal;
+	timing.chooseMSec		= chooseMSec;
+	timing.timeBase			= timeBase;
+	timing.timeBaseRat		= timeBaseRat;
+	strategy->setTiming(timing);
 
 	ok = true;
 	dumpFormat(0);
 
+	// Index the video packets, if this fails seeks fall back to predictions
+	bool indexed = buildIndex ? index.loadOrBuild(filename, videoStream) : index.load(filename, videoStream);
+	if (!indexed)
+		qDebug() << "Packets index not available, seeking will be approximated";
+	updateTimeline();
+
 	return true;
 }
 
@@ -292,9 +445,10 @@ bool QVideoDecoder::getFirstPacketInformation()
 			// Frame is completely decoded?
 			if (frameFinished) {
 
-				frameDuration = packet.duration;
-				firstDts = packet.dts;
-				startTs = packet.dts;
+				// with frame threading the frame doesn't come from this packet
+				frameDuration = ffmpeg::av_frame_get_pkt_duration(pFrame);
+				firstDts = (pFrame->pkt_dts != AV_NOPTS_VALUE) ? pFrame->pkt_dts : packet.dts;
+				startTs = firstDts;
 				done = true;
 
 				if (pFormatCtx->streams[videoStream]->first_dts == AV_NOPTS_VALUE) {
@@ -330,9 +484,6 @@ bool QVideoDecoder::decodeSeekFrame (const qint64 idealFrameNumber)
 	if (!ok)
 		return false;
 
-	qint64 f, t;
-	bool done = false;
-
 	// If the last decoded frame satisfies the time condition we return it
 	if (
 		idealFrameNumber != -1 &&
@@ -341,89 +492,180 @@ bool QVideoDecoder::decodeSeekFrame (const qint64 idealFrameNumber)
 		return true;
 	}   
 
-	while (!done) {
+	while (decodeNextFrame()) {
+		// this is the desired frame or at least one just after it
+		if (idealFrameNumber == -1 || LastFrameNumber >= idealFrameNumber)
+			return true;
+	}
+	return false;	// end of stream
+}
 
-		// Read a frame
-		if (av_read_frame(pFormatCtx, &packet)<0)
-			return false;	// end of stream?            
+/*! \brief Decode the next frame
+*
+*   Read packets until the codec outputs a frame and update the last frame
+*	infos with it.
+*	@return success or not, false at the end of the stream
+*/
+bool QVideoDecoder::decodeNextFrame()
+{
+	qint64 f, t;
+	bool endOfFile = false;
 
-		// Packet of the video stream?
-		if (packet.stream_index==videoStream) {
+	forever {
 
-			int frameFinished;
+		// Read a frame, at the end of the file the codec has to be drained: 
+		// B-frames and frame threads keep some frames inside it
+		if (!endOfFile) {
+			PROFILE_SCOPE("demux");
+			endOfFile = av_read_frame(pFormatCtx, &packet) < 0;
+		}
+		if (endOfFile) {
+			ffmpeg::av_init_packet(&packet);
+			packet.data = NULL;
+			packet.size = 0;
+			packet.stream_index = videoStream;
+		}
+
+		// Packet of another stream, or not a keyframe when only those are
+		// wanted?
+		if (
+			packet.stream_index != videoStream ||
+			(keyFramesOnly && !endOfFile && !(packet.flags & AV_PKT_FLAG_KEY))
+		) {
+			av_free_packet(&packet);
+			continue;
+		}
+
+		int frameFinished;
+		{
+			PROFILE_SCOPE("decode");
 			avcodec_decode_video2(pCodecCtx,pFrame,&frameFinished,&packet);
+		}
+		av_free_packet(&packet);
 
-			// Frame is completely decoded?
-			if (frameFinished) {
+		// Nothing left in the codec
+		if (endOfFile && !frameFinished)
+			return false;
 
-				// Calculate real frame number and time based on the format
-				if (type == "mpeg" || type == "asf") {
-					f = (long)((packet.dts - startTs) * (baseFrameRate*timeBase) + 0.5);
-					t = ffmpeg::av_rescale_q(packet.dts - startTs, timeBaseRat, millisecondbase);
-				}
-				else if (type.indexOf("mp4") != -1) {
-					f = (long)((packet.dts + firstDts) * (baseFrameRate*timeBase) + 0.5);
-					t = ffmpeg::av_rescale_q(packet.dts + firstDts, timeBaseRat, millisecondbase);
-				}
-				else if (type == "matroska,webm") {
-					// t = av_frame_get_best_effort_timestamp(pFrame);
-					// f = round(t / frameMSec);
-					t = ffmpeg::av_rescale_q(packet.dts - firstDts, timeBaseRat, millisecondbase);
-					f = round(t / frameMSec);
-				}
-				else { // avi
-					f = packet.dts;
-					t = ffmpeg::av_rescale_q(packet.dts, timeBaseRat, millisecondbase);
-				}
-				qDebug() << "id:" << idealFrameNumber;
-				qDebug() << "f:" << f;
-				qDebug() << "t:" << t;
-				qDebug() << "dur:" << packet.duration;
-				qDebug() << "dts:" << packet.dts << endl;
-
-				if (LastFrameOk) {
-					// If we decoded 2 frames in a row, the last times are okay
-					LastLastFrameTime = LastFrameTime;
-					LastLastFrameNumber = LastFrameNumber;
-					LastFrameTime = t;
-					LastFrameNumber = f;
-				}
-				else {
-					LastFrameOk = true;
-					LastLastFrameTime = LastFrameTime = t;
-					LastLastFrameNumber = LastFrameNumber = f;
-				}
+		// Frame is completely decoded?
+		if (frameFinished)
+			break;
+	}
 
-				// this is the desired frame or at least one just after it
-				if (idealFrameNumber == -1 || LastFrameNumber >= idealFrameNumber)
-				{
-					// Convert and save the frame
-					img_convert_ctx = ffmpeg::sws_getCachedContext(
-						img_convert_ctx, w, h, 
-						pCodecCtx->pix_fmt, w, h, 
-						ffmpeg::PIX_FMT_RGB24, SWS_BICUBIC, NULL, NULL, NULL
-					);
-
-					if (img_convert_ctx == NULL) {
-						qDebug() << "Cannot initialize the conversion context!";
-						return false;
-					}
-					ffmpeg::sws_scale(img_convert_ctx, pFrame->data, pFrame->linesize, 0, pCodecCtx->height, pFrameRGB->data, pFrameRGB->linesize);
-
-					LastFrame = QImage(w, h, QImage::Format_RGB888);
-
-					for (int y=0; y < h; y++)
-						memcpy(LastFrame.scanLine(y), pFrameRGB->data[0] + y * pFrameRGB->linesize[0], w * 3);
-
-					LastFrameOk = true;
-					done = true;
-				} // frame of interes
-			}  // frameFinished
-		}  // stream_index==videoStream
+	// Calculate real frame number and time based on the format.
+	// The frame can come out of the codec some packets after its
+	// own one (B-frames, frame threads): use the timestamps of the
+	// packet that produced it, not of the one just sent
+	qint64 pts = ffmpeg::av_frame_get_best_effort_timestamp(pFrame);
+	qint64 dts = pFrame->pkt_dts;
+	if (dts != AV_NOPTS_VALUE || (timeline.isValid() && pts != AV_NOPTS_VALUE)) {
+		computeFrameNumberAndTime(pts, dts, f, t);
+	}
+	else { // drained frame, it follows the last one
+		f = LastFrameNumber + 1;
+		t = timeline.isValid() ? timeline.frameTime(f) : LastFrameTime + frameMSec;
+	}
 
-		av_free_packet(&packet);
+	// pFrame holds a new frame, the colour conversion is done
+	// only if its image is asked
+	LastFrameConverted = false;
+
+	if (LastFrameOk) {
+		// If we decoded 2 frames in a row, the last times are okay
+		LastLastFrameTime = LastFrameTime;
+		LastLastFrameNumber = LastFrameNumber;
+		LastFrameTime = t;
+		LastFrameNumber = f;
+	}
+	else {
+		LastFrameOk = true;
+		LastLastFrameTime = LastFrameTime = t;
+		LastLastFrameNumber = LastFrameNumber = f;
+	}
+	return true;
+}
+
+/*! \brief Convert the last decoded frame
+*
+*   Convert the last decoded frame to an RGB32 image of the output size.
+*	swscale writes straight into a pooled image, no copies.
+*	@return success or not
+*/
+bool QVideoDecoder::convertLastFrame()
+{
+	// scaled down frames are small previews, the fast filter is enough
+	int dstW = getOutputWidth(), dstH = getOutputHeight();
+	bool scaled = dstW != pFrame->width || dstH != pFrame->height;
+
+	img_convert_ctx = ffmpeg::sws_getCachedContext(
+		img_convert_ctx, pFrame->width, pFrame->height, 
+		pCodecCtx->pix_fmt, dstW, dstH, 
+		ffmpeg::PIX_FMT_RGB32, scaled ? SWS_FAST_BILINEAR : SWS_BICUBIC, NULL, NULL, NULL
+	);
+
+	if (img_convert_ctx == NULL) {
+		qDebug() << "Cannot initialize the conversion context!";
+		return false;
 	}
-	return done;
+
+	LastFrame = framePool->acquire();
+	if (LastFrame.isNull()) {
+		qDebug() << "Cannot allocate the frame!";
+		return false;
+	}
+	uint8_t *dst[4] = { LastFrame.bits(), 0, 0, 0 };
+	int dstLinesize[4] = { LastFrame.bytesPerLine(), 0, 0, 0 };
+
+	PROFILE_SCOPE("sws_scale");
+	ffmpeg::sws_scale(img_convert_ctx, pFrame->data, pFrame->linesize, 0, pFrame->height, dst, dstLinesize);
+
+	LastFrameConverted = true;
+	return true;
+}
+
+/*! \brief Frame number and time of a packet
+*
+*   Calculate the real frame number and time of a packet: its position in the
+*	timeline when the packets index is available, otherwise a prediction
+*	based on the format and the frame rate.
+*	@param pts presentation timestamp of the packet
+*	@param dts decoding timestamp of the packet
+*	@param f where it stores the frame number
+*	@param t where it stores the frame time in milliseconds
+*/
+void QVideoDecoder::computeFrameNumberAndTime(const qint64 pts, const qint64 dts, qint64 &f, qint64 &t)
+{
+	if (timeline.isValid()) {
+		f = timeline.frameAtTs((pts != AV_NOPTS_VALUE) ? pts : dts);
+		t = timeline.frameTime(f);
+	}
+	else {
+		strategy->frameNumberAndTime((dts != AV_NOPTS_VALUE) ? dts : pts, f, t);
+	}
+}
+
+/*! \brief Frame number of a keyframe
+*
+*   Calculate the frame number of a keyframe of the packets index
+*	@param e the keyframe
+*	@return frame number
+*/
+qint64 QVideoDecoder::keyFrameNumber(const FrameIndexEntry &e)
+{
+	qint64 f, t;
+	computeFrameNumberAndTime(e.pts, e.dts, f, t);
+	return f;
+}
+
+/*! \brief Build the timeline
+*
+*   Build the timeline from the packets index, frame numbers and times come
+*	from it from now on.
+*/
+void QVideoDecoder::updateTimeline()
+{
+	if (!index.isValid() || !timeline.build(index, timeBaseRat))
+		timeline.clear();
 }
 
 /*! \brief Seek the next frame
@@ -444,6 +686,27 @@ bool QVideoDecoder::seekNextFrame()
 	return ret;
 }
 
+/*! \brief Read the next frame of the stream
+*
+*   Decode the frame that follows the last one, whatever its number: meant
+*	for reading the video sequentially (playback, analysis) after a single
+*	seek, so none of the seek checks are done.
+*	@return success or not, false at the end of the stream
+*   @see seekNextFrame()
+*/
+bool QVideoDecoder::readNextFrame()
+{
+	if (!ok)
+		return false;
+
+	if (!decodeNextFrame()) {
+		LastFrameOk = false;
+		return false;
+	}
+	LastIdealFrameNumber = LastFrameNumber;
+	return true;
+}
+
 /*! \brief Seek the previous frame
 *
 *   Seek the previous frame.
@@ -471,7 +734,7 @@ bool QVideoDecoder::seekMs(const qint64 tsms)
 {
    if(!ok)
 	  return false;
-	return seekFrame((tsms <= 0 ? 0 : round(tsms / frameMSec)));
+	return seekFrame(getNumFrameByTime(tsms));
 }
 
 /*! \brief Seek the desired frame
@@ -492,20 +755,23 @@ bool QVideoDecoder::seekFrame(const qint64 idealFrameNumber)
 	if (LastIdealFrameNumber + 1 == idealFrameNumber)
 		return seekNextFrame();
 	
-	// have to seek?
-	if ((LastFrameOk == false) || 
-		((LastFrameOk == true) && (idealFrameNumber <= LastLastFrameNumber || idealFrameNumber > LastFrameNumber)))
+	// have to seek? not if the frame can be reached decoding forward from
+	// the last one without crossing a keyframe
+	if (getForwardDistance(idealFrameNumber) < 0)
 	{
-		if (!correctSeekToKeyFrame(idealFrameNumber))
+		// use the packets index when available, otherwise guess the position
+		if (!seekToIndexedKeyFrame(idealFrameNumber) && !correctSeekToKeyFrame(idealFrameNumber))
 			return false;
 
 		avcodec_flush_buffers(pCodecCtx);
-		LastIdealFrameNumber = idealFrameNumber;
 		LastFrameOk = false;
 	}
 
 	// decode
-	return decodeSeekFrame(idealFrameNumber);
+	if (!decodeSeekFrame(idealFrameNumber))
+		return false;
+	LastIdealFrameNumber = idealFrameNumber;
+	return true;
 }
 
 /*! \brief Corrects the seeking operation
@@ -519,81 +785,62 @@ bool QVideoDecoder::seekFrame(const qint64 idealFrameNumber)
 */
 bool QVideoDecoder::correctSeekToKeyFrame(const qint64 idealFrameNumber)
 {
-	qint64 desiredDts;
-	qint64 startDts = INT64_MIN;
-	int flag;
-	//  
-	if (type == "mpeg") { // .mpg
-		// ffmpeg bug?: with H.264 avformat_seek_file often seeks not in a keyframe, 
-		// thus the following avcodec_decode_video2 iterations may go past desiredDts
-		desiredDts = (idealFrameNumber - 0.5 - baseFrameRate) / (baseFrameRate*timeBase) + firstDts;
-		if (desiredDts < firstDts)	desiredDts = firstDts;
-		startDts = -0x7ffffffffffffff;
-		flag = AVSEEK_FLAG_BACKWARD;
-	}
-	else if (type.indexOf("mp4") != -1){ // .mp4
-
-		qint64 targetDts = idealFrameNumber * frameMSecReal;
+	return strategy->seekToKeyFrame(pFormatCtx, pCodecCtx, videoStream, idealFrameNumber);
+}
 
-		// av_seek_frame(pFormatCtx, videoStream, targetDts, AVSEEK_FLAG_FRAME);
-		// flag = AVSEEK_FLAG_BACKWARD;
-		ffmpeg::avformat_seek_file(pFormatCtx, videoStream, startDts, targetDts, INT64_MAX, AVSEEK_FLAG_BACKWARD);
-		return true;
-	}
-	else if (type == "asf"){ // .asf (wmv)
+/*! \brief Seek to the keyframe preceding a frame using the index
+*
+*   Look up in the packets index the last keyframe placed before the desired
+*	frame and seek exactly to it, so that only its GOP has to be decoded.
+*	@param idealFrameNumber number of the desired frame
+*	@return success or not, false when the index is not available
+*   @see seekFrame()
+*/
+bool QVideoDecoder::seekToIndexedKeyFrame(const qint64 idealFrameNumber)
+{
+	int k = findKeyFrame(idealFrameNumber);
+	if (k == -1)
+		return false;
+	const FrameIndexEntry &key = index.keyFrameAt(k);
 
-		desiredDts = idealFrameNumber * frameMSec;
-		flag = AVSEEK_FLAG_BACKWARD;
-	}
-	else if (type == "matroska,webm") { // .mkv
-		bool reset = false; // used to avoid deadlock situation into the "while"
-
-		// this prediction is not perfect but it gives a good start point close 
-		// to the desired frame number
-		// while targetDts is based on the packets DTS, desiredDts is based on 
-		// the wanted DTS
-		qint64 targetDts = idealFrameNumber * chooseMSec; 
-		if (av_seek_frame(pFormatCtx, videoStream, targetDts, AVSEEK_FLAG_BACKWARD) < 0) {
-			return false;
-		}
-		avcodec_flush_buffers(pCodecCtx);
-		qint64 currDts = pFormatCtx->streams[videoStream]->cur_dts;
-		
-		while (currDts > targetDts) {
-
-			// if i am after the desired frame, have to reseek
-			targetDts -= (60 * chooseMSec); // go back of 60frames. TODO: a better value?
-			qDebug() << "back";
-			if (targetDts < 0) {
-				if (reset) {//already resetted before this? Possible deadlock!
-					return true; // false?
-				}
-				targetDts = 0;
-				reset = true;
-			}
-			else {
-				reset = false;
-			}
-
-			if (av_seek_frame(pFormatCtx, videoStream, targetDts, AVSEEK_FLAG_BYTE) < 0) {
-				return false;
-			}
-			avcodec_flush_buffers(pCodecCtx);
-			currDts = pFormatCtx->streams[videoStream]->cur_dts;
-		}
-		return true;
+	// program streams can be seeked exactly by byte, the others by timestamp
+	int ret;
+	if (strategy->canSeekByByte() && key.pos >= 0) {
+		ret = av_seek_frame(pFormatCtx, videoStream, key.pos, AVSEEK_FLAG_BYTE);
 	}
-	else { // .avi, .wmv
-		desiredDts = idealFrameNumber;
-		flag = AVSEEK_FLAG_FRAME;
-		
+	else {
+		qint64 ts = (key.pts != AV_NOPTS_VALUE) ? key.pts : key.dts;
+		ret = av_seek_frame(pFormatCtx, videoStream, ts, AVSEEK_FLAG_BACKWARD);
 	}
-	
-	if (ffmpeg::avformat_seek_file(pFormatCtx, videoStream, startDts, desiredDts, INT64_MAX, flag) < 0) {
-		return false;
-		// qDebug() << "!!!SEEK ERROR!!!"
+	return ret >= 0;
+}
+
+/*! \brief Find the keyframe preceding a frame
+*
+*   Binary search in the packets index of the last keyframe the decoding
+*	must start from to output the desired frame.
+*	@param idealFrameNumber number of the desired frame
+*	@return position of the keyframe in the index, -1 when the index is not
+*		available
+*/
+int QVideoDecoder::findKeyFrame(const qint64 idealFrameNumber)
+{
+	if (!index.isValid() || index.numKeyFrames() == 0)
+		return -1;
+
+	// frames can come out of the decoder with some delay, start a bit earlier
+	qint64 target = idealFrameNumber - pCodecCtx->has_b_frames;
+
+	// binary search of the last keyframe whose frame number is <= target
+	int lo = 0, hi = index.numKeyFrames();
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (keyFrameNumber(index.keyFrameAt(mid)) <= target)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
-	return true;
+	return (lo > 0) ? lo - 1 : 0;
 }
 
 /*! \brief Seek and retrieve desired frame
@@ -628,6 +875,25 @@ bool QVideoDecoder::isOk()
 	return ok;
 }
 
+/*! \brief the packets index is available?
+*
+*   Checks if the open video has its packets index, seeks are exact
+*/
+bool QVideoDecoder::hasIndex()
+{
+	return ok && index.isValid();
+}
+
+/*! \brief Get the packets index
+*
+*   Get the packets index of the video stream, not valid when it is not
+*	available
+*/
+const FrameIndex &QVideoDecoder::getIndex()
+{
+	return index;
+}
+
 /*! \brief Get last loaded frame
 *
 *   Get last loaded frame
@@ -638,6 +904,9 @@ bool QVideoDecoder::isOk()
 */
 bool QVideoDecoder::getFrame(QImage &img, qint64 *frameNum, qint64 *frameTime)
 {
+	if (LastFrameOk && !LastFrameConverted && !convertLastFrame())
+		return false;
+
 	img = LastFrame;
 
 	if (frameNum)
@@ -648,6 +917,111 @@ bool QVideoDecoder::getFrame(QImage &img, qint64 *frameNum, qint64 *frameTime)
 	return LastFrameOk;
 }
 
+/*! \brief Get the planes of the last loaded frame
+*
+*   Get the planes of the last loaded frame as decoded, without colour
+*	conversion. They belong to the codec and are valid until the next seek.
+*	@param planes where it stores the planes
+*	@param frameNum where it stores the frame number
+*	@param frameTime where it stores the frame time
+*	@return last frame was valid or not
+*/
+bool QVideoDecoder::getPlanes(VideoPlanes &planes, qint64 *frameNum, qint64 *frameTime)
+{
+	if (!LastFrameOk)
+		return false;
+
+	for (int i = 0; i < 4; ++i) {
+		planes.data[i] = pFrame->data[i];
+		planes.linesize[i] = pFrame->linesize[i];
+	}
+	planes.width = pFrame->width;
+	planes.height = pFrame->height;
+	planes.format = pCodecCtx->pix_fmt;
+
+	// 8 bit planar YUV: one byte per sample, a plane per component
+	const ffmpeg::AVPixFmtDescriptor *desc = ffmpeg::av_pix_fmt_desc_get(pCodecCtx->pix_fmt);
+	planes.planarYUV = desc && desc->nb_components >= 3 &&
+		!(desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL)) &&
+		(desc->flags & AV_PIX_FMT_FLAG_PLANAR);
+	for (int i = 0; planes.planarYUV && i < 3; ++i) {
+		planes.planarYUV = desc->comp[i].plane == i &&
+			desc->comp[i].step_minus1 == 0 && desc->comp[i].depth_minus1 == 7;
+	}
+	planes.chromaWidth = desc ? -((-planes.width) >> desc->log2_chroma_w) : 0;
+	planes.chromaHeight = desc ? -((-planes.height) >> desc->log2_chroma_h) : 0;
+
+	if (frameNum)
+		*frameNum = LastFrameNumber;
+	if (frameTime)
+		*frameTime = LastFrameTime;
+
+	return true;
+}
+
+/*! \brief Get the keyframe preceding a frame
+*
+*   Get the number of the keyframe a seek to the desired frame would start
+*	decoding from.
+*	@param idealFrameNumber number of the desired frame
+*	@return keyframe number, -1 when the packets index is not available
+*/
+qint64 QVideoDecoder::getKeyFrameNumber(const qint64 idealFrameNumber)
+{
+	int k = findKeyFrame(idealFrameNumber);
+	if (k == -1)
+		return -1;
+
+	return keyFrameNumber(index.keyFrameAt(k));
+}
+
+/*! \brief Get the frames to decode to reach a frame
+*
+*   Get the number of frames to decode to reach the desired frame from the
+*	current position, without seeking. It's possible only when no keyframe
+*	lies between the last decoded frame and the desired one.
+*	@param idealFrameNumber number of the desired frame
+*	@return number of frames, 0 when it's the last decoded one, -1 when a
+*		seek is needed
+*/
+qint64 QVideoDecoder::getForwardDistance(const qint64 idealFrameNumber)
+{
+	if (!ok || !LastFrameOk || idealFrameNumber <= LastLastFrameNumber)
+		return -1;
+	if (idealFrameNumber <= LastFrameNumber)
+		return 0;
+
+	qint64 key = getKeyFrameNumber(idealFrameNumber);
+	if (key == -1 || key > LastFrameNumber)
+		return -1;
+	return idealFrameNumber - LastFrameNumber;
+}
+
+/*! \brief Get the first frame of every GOP
+*
+*   Get, for every keyframe of the packets index, the first frame number whose
+*	seek starts decoding from it. Seeking to one of them never decodes the
+*	previous GOP, so the video can be split there in independent segments.
+*	@param starts where it stores the frame numbers, in increasing order
+*	@return success or not, false when the packets index is not available
+*/
+bool QVideoDecoder::getGopStarts(std::vector<qint64> &starts)
+{
+	starts.clear();
+	if (!ok || !index.isValid())
+		return false;
+
+	for (int k = 0; k < index.numKeyFrames(); ++k) {
+		// findKeyFrame() goes back by the decoder delay, compensate it
+		qint64 f = qMax((qint64) 0, keyFrameNumber(index.keyFrameAt(k)) + pCodecCtx->has_b_frames);
+		if (starts.empty() || f > starts.back())
+			starts.push_back(f);
+	}
+	if (!starts.empty())
+		starts[0] = 0;
+	return !starts.empty();
+}
+
 /*! \brief Get last loaded frame "CODEC number"
 *
 *   Get last loaded frame "CODEC number", "CODEC number" because codecs and
@@ -699,6 +1073,8 @@ qint64 QVideoDecoder::getNumFrameByTime(const qint64 tsms)
 		return false;
 	if (tsms <= 0)
 		return 0;
+	if (timeline.isValid())
+		return timeline.frameAtTime(tsms);
 	return round(tsms / frameMSec);
 }
 
@@ -712,23 +1088,38 @@ qint64 QVideoDecoder::getVideoLengthMs()
 	if (!isOk())
 		return -1;
 
+	// the packets give the exact length, the header only an estimate
+	if (timeline.isValid())
+		return timeline.getLengthMs();
+
 	qint64 secs = pFormatCtx->duration / AV_TIME_BASE;
 	qint64 us = pFormatCtx->duration % AV_TIME_BASE;
 	return secs * 1000 + us / 1000;
 }
 
-/*! \brief Get number of frames (Not accurate with some formats)
+/*! \brief Get number of frames
 *
-*   Get number of frames based on video duration and frame rate. Some containers
+*   Get number of frames, counted in the packets index when it is available.
+*	Otherwise it is based on video duration and frame rate: some containers
 *	save a wrong value for duration and so the number of frames could be not so
 *	accurate.
 *	@return number of frams
 */
 qint64 QVideoDecoder::getNumFrames()
 {
+	if (isOk() && timeline.isValid())
+		return timeline.numFrames();
 	return round(getVideoLengthMs() * (baseFrameRate / 1000.0));
 }
 
+/*! \brief Get video stream
+*
+*	Retrieve the index of the decoded stream in the file
+*/
+int QVideoDecoder::getVideoStream() {
+	return videoStream;
+}
+
 /*! \brief Get video path
 *
 *	Retrieve video path
@@ -806,6 +1197,22 @@ int QVideoDecoder::getFrameHeight() {
 	return h;
 }
 
+/*! \brief Get width of the converted frames
+*
+*	Get width of the frames returned by getFrame
+*/
+int QVideoDecoder::getOutputWidth() {
+	return outWidth > 0 ? outWidth : w;
+}
+
+/*! \brief Get height of the converted frames
+*
+*	Get height of the frames returned by getFrame
+*/
+int QVideoDecoder::getOutputHeight() {
+	return outHeight > 0 ? outHeight : h;
+}
+
 /*! \brief Get video bitrate
 *
 *	Get video bitrate
@@ -33,6 +33,22 @@
 #include <QDebug>
 
 #include "ffmpeg.h"
+#include "FrameIndex.h"
+#include "Timeline.h"
+#include "FramePool.h"
+#include "ContainerStrategy.h"
+
+//! Planes of a decoded frame, as the codec outputs them
+struct VideoPlanes {
+	const uint8_t	*data[4];
+	int				linesize[4];
+	int				width;
+	int				height;
+	int				chromaWidth;	//!< width of the chroma planes
+	int				chromaHeight;	//!< height of the chroma planes
+	int				format;			//!< ffmpeg::AVPixelFormat
+	bool			planarYUV;		//!< data[0..2] are 8 bit Y, U and V planes
+};
 
 /*!
 *	@brief Class used to decode frames from the file video
@@ -43,22 +59,37 @@
 */
 class QVideoDecoder
 {
+	public:
+		//! How the codec spreads the decoding over threads
+		enum ThreadingMode {
+			ThreadingAuto,	//!< frame and slice threads, whatever the codec supports
+			ThreadingFrame,	//!< consecutive frames in parallel, adds latency
+			ThreadingSlice,	//!< slices of the same frame in parallel
+			ThreadingNone	//!< single thread
+		};
+
 	protected:
 		// Basic FFmpeg stuff
 		ffmpeg::AVFormatContext	*pFormatCtx;
 		ffmpeg::AVCodecContext	*pCodecCtx;
 		ffmpeg::AVCodec			*pCodec;
 		ffmpeg::AVFrame			*pFrame;
-		ffmpeg::AVFrame			*pFrameRGB;
 		ffmpeg::AVPacket		packet;
 		ffmpeg::SwsContext		*img_convert_ctx;
-		uint8_t					*buffer;
+		QSharedPointer<FramePool> framePool; //!< memory of the converted frames
 		int						videoStream; //!< index of the video stream
-		int						numBytes;
+		ThreadingMode			threadingMode; //!< codec threading, applied when opening
+		int						threadCount; //!< codec threads, 0 = one per core
+		int						outWidth; //!< width of the converted frames, 0 = frame width
+		int						outHeight; //!< height of the converted frames, 0 = frame height
+		int						lowres; //!< the codec decodes at 1/2^lowres of the size
+		bool					keyFramesOnly; //!< non-key packets are dropped unread by the codec
+		bool					buildIndex; //!< openFile builds the missing packets index
 
 		// Video informations
 		QString					path; //!< file path
 		QString					type; //!< format type
+		ContainerStrategy		*strategy; //!< timestamps handling of type
 		int						w; //!< frame width
 		int						h; //!< framw height
 		qint64					duration; //!< video duration
@@ -74,10 +105,13 @@ class QVideoDecoder
 		double					timeBase; //!< base time reference
 		ffmpeg::AVRational		timeBaseRat;
 		ffmpeg::AVRational		millisecondbase; //!< wanted base time reference
+		FrameIndex				index; //!< packets index of the video stream
+		Timeline				timeline; //!< frames times, from the packets index
 
 		// State infos
 		bool ok;
 		bool LastFrameOk; //!< last frame is valid
+		bool LastFrameConverted; //!< LastFrame holds the last decoded frame
 		QImage LastFrame;
 		qint64 LastFrameNumber, LastFrameTime, LastIdealFrameNumber;
 		qint64 LastLastFrameNumber, LastLastFrameTime;
@@ -89,7 +123,14 @@ class QVideoDecoder
 
 		// Seek
 		virtual bool decodeSeekFrame(const qint64 idealFrameNumber);
+		bool decodeNextFrame();
 		virtual bool correctSeekToKeyFrame(const qint64 idealFrameNumber);
+		virtual bool seekToIndexedKeyFrame(const qint64 idealFrameNumber);
+		int findKeyFrame(const qint64 idealFrameNumber);
+		void computeFrameNumberAndTime(const qint64 pts, const qint64 dts, qint64 &f, qint64 &t);
+		qint64 keyFrameNumber(const FrameIndexEntry &e);
+		void updateTimeline();
+		bool convertLastFrame();
 
 		// Helpers
 		virtual void dumpFormat(const int is_output);
@@ -103,9 +144,17 @@ class QVideoDecoder
 
 		virtual bool openFile(const QString file);
 		virtual void close();
+		void setThreading(const ThreadingMode mode, const int count = 0);
+		void setOutputSize(const int width, const int height);
+		void setKeyFramesOnly(const bool enable);
+		void setBuildIndex(const bool enable);
+		bool loadIndex();
+		bool setIndex(const FrameIndex &idx);
 
 		virtual bool getFrame(QImage&img, qint64 *frameNum = 0, qint64 *frameTime = 0);
+		virtual bool getPlanes(VideoPlanes &planes, qint64 *frameNum = 0, qint64 *frameTime = 0);
 		virtual bool seekNextFrame();
+		bool readNextFrame();
 		virtual bool seekPrevFrame();
 		virtual bool seekMs(const qint64 ts);
 		virtual bool seekFrame(const qint64 frame);
@@ -121,13 +170,19 @@ class QVideoDecoder
 		virtual qint64 getIdealFrameNumber();
 		virtual qint64 getFrameTime();
 		virtual qint64 getNumFrameByTime(const qint64 tsms);
+		qint64 getKeyFrameNumber(const qint64 idealFrameNumber);
+		qint64 getForwardDistance(const qint64 idealFrameNumber);
+		bool getGopStarts(std::vector<qint64> &starts);
 
 		virtual bool isOk();
+		bool hasIndex();
+		const FrameIndex &getIndex();
 
 		qint64				getVideoLengthMs();
 		qint64				getNumFrames();
 		QString				getPath();
 		QString				getType();
+		int					getVideoStream();
 		ffmpeg::AVRational	getTimeBaseRat();
 		double				getTimeBase();
 		double				getFrameRate();
@@ -135,6 +190,8 @@ class QVideoDecoder
 		double				getFrameMsecReal();
 		int					getFrameWidth();
 		int					getFrameHeight();
+		int					getOutputWidth();
+		int					getOutputHeight();
 		QString				getBitrate();
 		QString				getProgramsString();
 		QString				getMetadataString();
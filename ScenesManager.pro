@@ -11,8 +11,21 @@ TEMPLATE = app
 SOURCES +=  main.cpp \
             mainwindow.cpp \
             QVideoDecoder.cpp \
+            FrameIndex.cpp \
+            Timeline.cpp \
+            ContainerStrategy.cpp \
+            FramePool.cpp \
             PlayerWidget.cpp \
+            VideoSurface.cpp \
             ImagesBuffer.cpp \
+            FramePrefetcher.cpp \
+            DecoderPool.cpp \
+            FrameSeeker.cpp \
+            Filmstrip.cpp \
+            ThumbnailStore.cpp \
+            IndexScanner.cpp \
+            PlaybackEngine.cpp \
+            FrameCache.cpp \
             PreviewsWidget.cpp \
             CompareMarkersDialog.cpp \
             MarkersWidget.cpp \
@@ -23,9 +36,23 @@ SOURCES +=  main.cpp \
 
 HEADERS +=  mainwindow.h \
             QVideoDecoder.h \
+            FrameIndex.h \
+            Timeline.h \
+            ContainerStrategy.h \
+            FramePool.h \
             ffmpeg.h \
             PlayerWidget.h \
+            VideoSurface.h \
             ImagesBuffer.h \
+            FramePrefetcher.h \
+            DecoderPool.h \
+            FrameSeeker.h \
+            Filmstrip.h \
+            ThumbnailStore.h \
+            IndexScanner.h \
+            PlaybackEngine.h \
+            FrameCache.h \
+            Frame.h \
             PreviewsWidget.h \
             CompareMarkersDialog.h \
             MarkersWidget.h \
@@ -41,59 +68,11 @@ RESOURCES += resource.qrc \
     windowicons.qrc
 DEFINES += DEVELMODE
 
-# ##############################################################################
-# Modify the below path so that it point to the folder containing
-# .lib, .dll.a and .def files of ffmpeg
-# ##############################################################################
-win32 {
-    FFMPEG_LIBRARY_PATH = ffmpeg_lib_win64
-}
-unix {
-    FFMPEG_LIBRARY_PATH = "/usr/local/lib"
-    FFMPEG_INCLUDE_PATH += "/usr/local/include"
-}
-# ##############################################################################
-# Do not modify from here: FFMPEG default settings
-# ##############################################################################
-win32 {
-# Set list of required FFmpeg libraries
-    LIBS += -L"$$PWD/$$FFMPEG_LIBRARY_PATH"
-    LIBS += -lavutil \
-            -lavcodec \
-            -lavformat \
-            -lswscale
-# Related includes
-    INCLUDEPATH +=  $$PWD/libavutil \
-                    $$PWD/libavcodec \
-                    $$PWD/libavdevice \
-                    $$PWD/libavformat \
-                    $$PWD/libswscale
-    DEPENDPATH +=   $$PWD/libavutil \
-                    $$PWD/libavcodec \
-                    $$PWD/libavdevice \
-                    $$PWD/libavformat \
-                    $$PWD/libswscale
-}
-unix {
-# Set list of required FFmpeg libraries
-    LIBS += -L"$$FFMPEG_LIBRARY_PATH"
-    LIBS += -lavcodec \
-            -lavdevice \
-            -lavfilter \
-            -lavformat \
-            -lavutil \
-            -lpostproc \
-            -lswresample \
-            -lswscale \
-            -lx264 \
-            -lz
-# Related includes
-    INCLUDEPATH += FFMPEG_INCLUDE_PATH
-}
-
-# Requied for some C99 defines
-DEFINES += __STDC_CONSTANT_MACROS
+include(ffmpeg.pri)
+include(profiler.pri)
 
-# ##############################################################################
-# FFMPEG: END OF CONFIGURATION
-# ##############################################################################
+# the timings overlay is only built with the timers
+contains(DEFINES, PROFILING) {
+    SOURCES += ProfilerOverlay.cpp
+    HEADERS += ProfilerOverlay.h
+}
@@ -0,0 +1,460 @@
+#include <QFile>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+
+#include "ShotDetector.h"
+#include "BatchDecoder.h"
+#include "FrameKernels.h"
+
+#define EDGE_THRESHOLD	48	// luma gradient of an edge sample
+
+/*! \brief Create the detector
+*
+*	Create the detector with the default parameters
+*/
+ShotDetector::ShotDetector()
+{
+	_hardThreshold	= 0.5;
+	_softThreshold	= 0.2;
+	_adaptiveFactor	= 4;
+	_window			= 30;
+	_minShotLength	= 8;
+	_jobs			= 0;
+}
+
+/*! \brief Destroyer
+*
+*	Destroyer
+*/
+ShotDetector::~ShotDetector()
+{
+	_decoder.close();
+}
+
+
+/**************************************
+*******    DETECTION ACTIONS    *******
+***************************************/
+
+/*! \brief open a video
+*
+*	Open the video to analyze
+*	@param fileName path to the video
+*	@param threading how the codec spreads the decoding over threads
+*	@param threads number of codec threads, 0 = one per core
+*	@return success or not
+*/
+bool ShotDetector::open(
+	const QString fileName,
+	const QVideoDecoder::ThreadingMode threading,
+	const int threads
+)
+{
+	_shots.clear();
+	_decoder.setThreading(threading, threads);
+	return _decoder.openFile(fileName) && _decoder.isOk();
+}
+
+/*! \brief detect the shots
+*
+*	Decode the whole video from the first frame and split it into shots.
+*	@param progress called every second of video with the current frame
+*		number and the number of frames, can be null
+*	@return success or not
+*/
+bool ShotDetector::detect(std::function<void(qint64, qint64)> progress)
+{
+	_shots.clear();
+	if (!_decoder.isOk())
+		return false;
+
+	const qint64 numFrames = _decoder.getNumFrames();
+	const int progressStep = qMax(1, (int) round(_decoder.getFrameRate()));
+
+	FrameFeatures prev, curr;
+	std::deque<double> diffs;	// differences of the last frames of the shot
+	qint64 shotStart = 0;
+	qint64 last = -1;			// number of the last frame added
+
+	// frames must come in order, numbered by the decoder, the features of a
+	// frame are swapped with the previous ones
+	auto addFrame = [&](FrameFeatures &ft, const qint64 num) {
+		if (num <= last)		// given again by the decoder
+			return;
+		if (last >= 0) {
+			double diff = difference(prev, ft);
+
+			// local statistics of the differences inside the shot
+			double mean = 0, var = 0;
+			for (double d : diffs)
+				mean += d;
+			if (!diffs.empty())
+				mean /= diffs.size();
+			for (double d : diffs)
+				var += (d - mean) * (d - mean);
+			if (!diffs.empty())
+				var /= diffs.size();
+
+			bool cut = diff > _hardThreshold || (
+				diff > _softThreshold &&
+				(int) diffs.size() >= _window / 2 &&
+				diff > mean + _adaptiveFactor * sqrt(var)
+			);
+
+			if (cut && num - shotStart >= _minShotLength) {
+				addShot(shotStart, last);
+				shotStart = num;
+				diffs.clear();
+			}
+			else {
+				diffs.push_back(diff);
+				if ((int) diffs.size() > _window)
+					diffs.pop_front();
+			}
+		}
+		std::swap(prev, ft);
+		last = num;
+
+		if (progress && num % progressStep == 0)
+			progress(num, numFrames);
+	};
+
+	// segments decoded in parallel, the features are computed by the workers
+	BatchDecoder batch(_jobs);
+	if (_jobs != 1 && batch.open(_decoder.getPath()) && batch.getNumSegments() > 1) {
+		bool failed = false;	// stopping the consumer isn't a failure of the batch
+		bool ok = batch.run(
+			[&](BatchFrame &f) {
+				if (!f.data.isValid()) {
+					failed = true;
+					return false;
+				}
+				curr = f.data.value<FrameFeatures>();
+				addFrame(curr, f.num);
+				return true;
+			},
+			[this](QVideoDecoder &decoder, BatchFrame &f) {
+				FrameFeatures ft;
+				if (readFeatures(decoder, ft))
+					f.data = QVariant::fromValue(ft);
+			}
+		);
+		if (!ok || failed)
+			return false;
+	}
+	else {
+		if (!_decoder.seekFrame(0))
+			return false;
+		for (bool ok = true; ok && readFeatures(_decoder, curr); ok = _decoder.readNextFrame())
+			addFrame(curr, _decoder.getActualFrameNumber());
+	}
+
+	if (last < 0)
+		return false;
+
+	// last shot, merged with the previous one if too short to be a marker
+	if (last > shotStart)
+		addShot(shotStart, last);
+	else if (!_shots.empty())
+		_shots.back().end = last;
+
+	if (progress)
+		progress(last + 1, numFrames);
+	return true;
+}
+
+/*! \brief store the shots as markers
+*
+*	Store the shots in a markers file, one "start end" line per shot.
+*	@param fileName path of the markers file
+*	@return success or not
+*/
+bool ShotDetector::saveMarkers(const QString fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+		return false;
+
+	for (const Shot &s : _shots)
+		file.write(QString("%1 %2\n").arg(s.start).arg(s.end).toLatin1());
+	return true;
+}
+
+
+/**************************************
+************    HELPERS    ************
+***************************************/
+
+/*! \brief read the features of the decoded frame
+*
+*	Compute the features of the last frame decoded by a decoder, from the
+*	YUV planes when possible: the RGB conversion costs more than the whole
+*	analysis. It can be called from any thread.
+*	@param decoder decoder on the frame
+*	@param ft where the features will be stored
+*	@return success or not
+*/
+bool ShotDetector::readFeatures(QVideoDecoder &decoder, FrameFeatures &ft)
+{
+	VideoPlanes planes;
+	QImage img;
+
+	if (decoder.getPlanes(planes) && planes.planarYUV)
+		computeFeatures(planes, ft);
+	else if (decoder.getFrame(img))
+		computeFeatures(img, ft);
+	else
+		return false;
+	return true;
+}
+
+/*! \brief compute the features of a frame
+*
+*	Compute histograms, luma and edges of an RGB32 frame on a grid of
+*	samples, so the cost of comparing frames doesn't depend on the resolution
+*	of the video.
+*	@param img RGB32 frame
+*	@param ft where the features will be stored
+*/
+void ShotDetector::computeFeatures(const QImage &img, FrameFeatures &ft)
+{
+	const int gw = SHOTDETECTOR_GRID_W, gh = SHOTDETECTOR_GRID_H;
+
+	// luma thumbnail, every pixel of the frame contributes
+	ft.luma.assign(gw * gh, 0);
+	FrameKernels::downsampleLuma(
+		img.constBits(), img.width(), img.height(), img.bytesPerLine(),
+		&ft.luma[0], gw, gh
+	);
+
+	// histograms on about the same number of pixels of the thumbnail
+	quint32 hist[3 * 256];
+	int step = qMax(1, qMin(img.width() / gw, img.height() / gh));
+	FrameKernels::histogramRGB32(
+		img.constBits(), img.width(), img.height(), img.bytesPerLine(), step, hist
+	);
+	reduceHistograms(hist, ft);
+
+	computeEdges(ft);
+}
+
+/*! \brief compute the features of a decoded frame
+*
+*	Compute histograms, luma and edges of a frame directly on the Y, U and V
+*	planes given by the codec, no colour conversion needed.
+*	@param planes 8 bit planar YUV frame
+*	@param ft where the features will be stored
+*/
+void ShotDetector::computeFeatures(const VideoPlanes &planes, FrameFeatures &ft)
+{
+	const int gw = SHOTDETECTOR_GRID_W, gh = SHOTDETECTOR_GRID_H;
+
+	// luma thumbnail, every pixel of the frame contributes
+	ft.luma.assign(gw * gh, 0);
+	FrameKernels::downsamplePlane(
+		planes.data[0], planes.width, planes.height, planes.linesize[0],
+		&ft.luma[0], gw, gh
+	);
+
+	// Y, U and V histograms on about the same number of pixels of the thumbnail
+	quint32 hist[3 * 256];
+	int step = qMax(1, qMin(planes.width / gw, planes.height / gh));
+	int chromaStep = qMax(1, step * planes.chromaWidth / planes.width);
+	FrameKernels::histogramPlane(
+		planes.data[0], planes.width, planes.height, planes.linesize[0], step, hist
+	);
+	for (int i = 1; i < 3; ++i) {
+		FrameKernels::histogramPlane(
+			planes.data[i], planes.chromaWidth, planes.chromaHeight, planes.linesize[i],
+			chromaStep, hist + i * 256
+		);
+	}
+	reduceHistograms(hist, ft);
+
+	computeEdges(ft);
+}
+
+/*! \brief reduce histograms
+*
+*	Reduce three 256 bins histograms to the normalized histograms of the
+*	features.
+*	@param hist three 256 bins histograms
+*	@param ft where the histograms will be stored
+*/
+void ShotDetector::reduceHistograms(const quint32 *hist, FrameFeatures &ft)
+{
+	const int bins = SHOTDETECTOR_HIST_BINS;
+	const int shift = 4; // 256 values -> 16 bins
+
+	ft.hist.assign(3 * bins, 0);
+	for (int c = 0; c < 3; ++c) {
+		quint32 total = 0;
+		for (int i = 0; i < 256; ++i) {
+			ft.hist[c * bins + (i >> shift)] += hist[c * 256 + i];
+			total += hist[c * 256 + i];
+		}
+		for (int b = 0; b < bins && total > 0; ++b)
+			ft.hist[c * bins + b] /= total;
+	}
+}
+
+/*! \brief compute the edges
+*
+*	Compute the edges of the luma thumbnail and grow them by one sample.
+*	@param ft features with the luma thumbnail, where edges will be stored
+*/
+void ShotDetector::computeEdges(FrameFeatures &ft)
+{
+	const int gw = SHOTDETECTOR_GRID_W, gh = SHOTDETECTOR_GRID_H;
+
+	ft.edges.assign(gw * gh, 0);
+	ft.dilated.assign(gw * gh, 0);
+	ft.numEdges = 0;
+
+	// gradient magnitude of the luma
+	for (int y = 1; y < gh - 1; ++y) {
+		for (int x = 1; x < gw - 1; ++x) {
+			const uchar *l = &ft.luma[y * gw + x];
+			int gx = abs(l[1] - l[-1]);
+			int gy = abs(l[gw] - l[-gw]);
+			if (gx + gy > EDGE_THRESHOLD) {
+				ft.edges[y * gw + x] = 1;
+				++ft.numEdges;
+			}
+		}
+	}
+	for (int y = 1; y < gh - 1; ++y) {
+		for (int x = 1; x < gw - 1; ++x) {
+			if (ft.edges[y * gw + x]) {
+				for (int dy = -1; dy <= 1; ++dy)
+					memset(&ft.dilated[(y + dy) * gw + x - 1], 1, 3);
+			}
+		}
+	}
+}
+
+/*! \brief difference between two frames
+*
+*	Mix of histogram distance, mean luma difference and edge change ratio of
+*	two frames.
+*	@param a features of the first frame
+*	@param b features of the second frame
+*	@return difference from 0 (same frame) to 1
+*/
+double ShotDetector::difference(const FrameFeatures &a, const FrameFeatures &b)
+{
+	// histograms: L1 distance, halved so it's in [0, 1] for each channel
+	double hist = 0;
+	for (size_t i = 0; i < a.hist.size(); ++i)
+		hist += fabs(a.hist[i] - b.hist[i]);
+	hist /= 2 * 3;
+
+	// luma: mean absolute difference, small values matter
+	double luma = FrameKernels::sad(&a.luma[0], &b.luma[0], a.luma.size());
+	luma = qMin(1.0, 4 * luma / (255.0 * a.luma.size()));
+
+	// edge change ratio: edges appeared or vanished far from the old/new ones
+	int entering = 0, exiting = 0;
+	for (size_t i = 0; i < a.edges.size(); ++i) {
+		if (b.edges[i] && !a.dilated[i])
+			++entering;
+		if (a.edges[i] && !b.dilated[i])
+			++exiting;
+	}
+	double ecr = qMax(
+		b.numEdges ? entering / (double) b.numEdges : 0,
+		a.numEdges ? exiting / (double) a.numEdges : 0
+	);
+
+	return 0.5 * hist + 0.2 * luma + 0.3 * ecr;
+}
+
+/*! \brief add a shot
+*
+*	Add a shot to the list
+*	@param start first frame number
+*	@param end last frame number
+*/
+void ShotDetector::addShot(const qint64 start, const qint64 end)
+{
+	Shot s;
+	s.start = start;
+	s.end = end;
+	_shots.push_back(s);
+}
+
+
+/**************************************
+*********        SETTERS      *********
+***************************************/
+
+/*! \brief Set the thresholds
+*
+*	Set the cut thresholds
+*	@param hard difference that is always a cut
+*	@param soft min difference of a cut found by the local statistics
+*	@param factor std deviations over the local mean of a cut
+*/
+void ShotDetector::setThresholds(const double hard, const double soft, const double factor)
+{
+	_hardThreshold = hard;
+	_softThreshold = soft;
+	_adaptiveFactor = factor;
+}
+
+/*! \brief Set the min shot length
+*
+*	Set the min number of frames of a shot, shorter ones (e.g. flashes)
+*	are merged with the previous shot
+*	@param frames number of frames, at least 2
+*/
+void ShotDetector::setMinShotLength(const int frames)
+{
+	_minShotLength = qMax(2, frames);
+}
+
+
+/*! \brief Set the parallel decoding
+*
+*	Set the number of segments of the video decoded in parallel, each on its
+*	own thread with its own decoder. The video is decoded sequentially when
+*	it has no packets index.
+*	@param jobs number of threads, 0 = one per core, 1 = sequential decoding
+*/
+void ShotDetector::setJobs(const int jobs)
+{
+	_jobs = qMax(0, jobs);
+}
+
+
+/**************************************
+*********        GETTERS      *********
+***************************************/
+
+/*! \brief Get the shots
+*
+*	Retrieve the shots detected by the last detect()
+*/
+const std::vector<Shot> &ShotDetector::getShots()
+{
+	return _shots;
+}
+
+/*! \brief Get number of frames
+*
+*	Retrieve the number of frames of the video
+*/
+qint64 ShotDetector::getNumFrames()
+{
+	return _decoder.getNumFrames();
+}
+
+/*! \brief Get video frame rate
+*
+*	Retrieve video frame rate
+*/
+double ShotDetector::getFrameRate()
+{
+	return _decoder.getFrameRate();
+}
@@ -0,0 +1,93 @@
+#ifndef SHOTDETECTOR_H
+#define SHOTDETECTOR_H
+
+#include <QString>
+#include <QMetaType>
+#include <vector>
+#include <functional>
+
+#include "QVideoDecoder.h"
+
+#define SHOTDETECTOR_GRID_W		160		// samples per row of the features grid
+#define SHOTDETECTOR_GRID_H		90		// samples per column of the features grid
+#define SHOTDETECTOR_HIST_BINS	16		// histogram bins per channel
+
+//! Features of a single frame, computed on a grid of samples
+struct FrameFeatures {
+	std::vector<float>	hist;	//!< normalized R, G and B (or Y, U and V) histograms
+	std::vector<uchar>	luma;	//!< luma of each sample
+	std::vector<uchar>	edges;	//!< 1 where the sample is on an edge
+	std::vector<uchar>	dilated;	//!< edges grown by one sample
+	int					numEdges = 0;
+};
+Q_DECLARE_METATYPE(FrameFeatures)
+
+//! Detected shot, as a marker
+struct Shot {
+	qint64 start;	//!< first frame number
+	qint64 end;		//!< last frame number
+};
+
+/*!
+*	@brief Class used to detect the shots of a video without user interface
+*
+*	Class used to detect the shots of a video without user interface.
+*	The video is split in segments decoded in parallel by a BatchDecoder, or
+*	decoded sequentially with a QVideoDecoder when it has no packets index, and
+*	for each frame a few cheap features are computed on a grid of samples:
+*	colour histograms, luma and edges. They are read from the decoded YUV
+*	planes when possible, so frames are never converted to RGB.
+*	The difference between two consecutive frames mixes histogram distance,
+*	mean luma difference and edge change ratio; a cut is placed where it is
+*	above a fixed threshold, or well above the differences of the previous
+*	frames. Shots are stored in the same "start end" format read by the
+*	MarkersWidget.
+*/
+class ShotDetector
+{
+	QVideoDecoder		_decoder;
+	std::vector<Shot>	_shots;
+
+	//  Parameters
+	double	_hardThreshold;		//!< difference that is always a cut
+	double	_softThreshold;		//!< min difference of an adaptive cut
+	double	_adaptiveFactor;	//!< std deviations over the local mean
+	int		_window;			//!< frames of the local statistics
+	int		_minShotLength;		//!< frames
+	int		_jobs;				//!< segments decoded in parallel, 0 = one per core
+
+	//  Helpers
+	bool	readFeatures(QVideoDecoder &decoder, FrameFeatures &ft);
+	void	computeFeatures(const QImage &img, FrameFeatures &ft);
+	void	computeFeatures(const VideoPlanes &planes, FrameFeatures &ft);
+	void	reduceHistograms(const quint32 *hist, FrameFeatures &ft);
+	void	computeEdges(FrameFeatures &ft);
+	double	difference(const FrameFeatures &a, const FrameFeatures &b);
+	void	addShot(const qint64 start, const qint64 end);
+
+public:
+
+	ShotDetector();
+	~ShotDetector();
+
+	//  Detection actions
+	bool	open(
+		const QString fileName,
+		const QVideoDecoder::ThreadingMode threading = QVideoDecoder::ThreadingAuto,
+		const int threads = 0
+	);
+	bool	detect(std::function<void(qint64, qint64)> progress = 0);
+	bool	saveMarkers(const QString fileName);
+
+	//  Setters
+	void	setThresholds(const double hard, const double soft, const double factor);
+	void	setMinShotLength(const int frames);
+	void	setJobs(const int jobs);
+
+	//  Getters
+	const std::vector<Shot> &getShots();
+	qint64	getNumFrames();
+	double	getFrameRate();
+};
+
+#endif // SHOTDETECTOR_H
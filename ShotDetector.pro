@@ -0,0 +1,35 @@
+# -------------------------------------------------
+# Command line shot detection, no user interface
+# -------------------------------------------------
+QT       += core gui
+QT       -= widgets
+CONFIG   += c++11 console
+CONFIG   -= app_bundle
+
+TARGET = ShotDetector
+TEMPLATE = app
+
+SOURCES +=  ShotDetectorMain.cpp \
+            ShotDetector.cpp \
+            BatchDecoder.cpp \
+            DecoderPool.cpp \
+            FrameKernels.cpp \
+            QVideoDecoder.cpp \
+            FrameIndex.cpp \
+            Timeline.cpp \
+            ContainerStrategy.cpp \
+            FramePool.cpp
+
+HEADERS +=  ShotDetector.h \
+            BatchDecoder.h \
+            DecoderPool.h \
+            FrameKernels.h \
+            QVideoDecoder.h \
+            FrameIndex.h \
+            Timeline.h \
+            ContainerStrategy.h \
+            FramePool.h \
+            ffmpeg.h
+
+include(ffmpeg.pri)
+include(profiler.pri)
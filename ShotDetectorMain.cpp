@@ -0,0 +1,106 @@
+/*
+   ShotManager (2015 x64)
+		Luca Gallinari
+		Dario Stabili
+		Marco Ravazzini
+
+	Command line shot detection: decodes a video and writes a markers file
+	with one marker per detected shot, ready to be reviewed in ScenesManager.
+
+*/
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <cstdio>
+
+#include "ShotDetector.h"
+
+static bool verbose = false;
+
+/*! \brief Message handler
+*
+*	Drop the decoder debug messages unless verbose output is requested,
+*	they would slow down the analysis a lot
+*/
+static void messageHandler(QtMsgType type, const QMessageLogContext &, const QString &msg)
+{
+	if (type == QtDebugMsg && !verbose)
+		return;
+	fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+	QCoreApplication::setApplicationName("ShotDetector");
+	qInstallMessageHandler(messageHandler);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Detect the shots of a video and store them as markers.");
+	parser.addHelpOption();
+	parser.addPositionalArgument("video", "Video to analyze.");
+	QCommandLineOption outputOpt(QStringList() << "o" << "output", "Markers file, <video>.txt by default.", "file");
+	QCommandLineOption hardOpt("hard", "Difference that is always a cut (0-1, default 0.5).", "value", "0.5");
+	QCommandLineOption softOpt("soft", "Min difference of an adaptive cut (0-1, default 0.2).", "value", "0.2");
+	QCommandLineOption factorOpt("factor", "Std deviations over the local mean of an adaptive cut (default 4).", "value", "4");
+	QCommandLineOption minOpt("min-length", "Min frames of a shot (default 8).", "frames", "8");
+	QCommandLineOption threadsOpt("threads", "Decoding threads of a sequential decoding, 0 = one per core (default 0).", "num", "0");
+	QCommandLineOption jobsOpt(QStringList() << "j" << "jobs", "Segments decoded in parallel, 0 = one per core, 1 = sequential (default 0).", "num", "0");
+	QCommandLineOption verboseOpt(QStringList() << "v" << "verbose", "Print the decoder messages.");
+	parser.addOption(outputOpt);
+	parser.addOption(hardOpt);
+	parser.addOption(softOpt);
+	parser.addOption(factorOpt);
+	parser.addOption(minOpt);
+	parser.addOption(threadsOpt);
+	parser.addOption(jobsOpt);
+	parser.addOption(verboseOpt);
+	parser.process(a);
+
+	if (parser.positionalArguments().size() != 1)
+		parser.showHelp(1);
+
+	verbose = parser.isSet(verboseOpt);
+	QString video = parser.positionalArguments().at(0);
+	QString output = parser.isSet(outputOpt) ? parser.value(outputOpt) : video + ".txt";
+
+	ShotDetector detector;
+	detector.setThresholds(
+		parser.value(hardOpt).toDouble(),
+		parser.value(softOpt).toDouble(),
+		parser.value(factorOpt).toDouble()
+	);
+	detector.setMinShotLength(parser.value(minOpt).toInt());
+	detector.setJobs(parser.value(jobsOpt).toInt());
+
+	if (!detector.open(video, QVideoDecoder::ThreadingAuto, parser.value(threadsOpt).toInt())) {
+		fprintf(stderr, "Cannot open %s\n", video.toLocal8Bit().constData());
+		return 2;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	bool ok = detector.detect([&timer](qint64 num, qint64 total) {
+		double secs = timer.elapsed() / 1000.0;
+		fprintf(stderr, "\r%lld/%lld frames, %.1f fps", (long long) num, (long long) total, secs > 0 ? num / secs : 0.0);
+	});
+	fprintf(stderr, "\n");
+
+	if (!ok) {
+		fprintf(stderr, "Cannot decode %s\n", video.toLocal8Bit().constData());
+		return 3;
+	}
+
+	if (!detector.saveMarkers(output)) {
+		fprintf(stderr, "Cannot write %s\n", output.toLocal8Bit().constData());
+		return 4;
+	}
+
+	double secs = timer.elapsed() / 1000.0;
+	double videoSecs = detector.getNumFrames() / detector.getFrameRate();
+	fprintf(stderr, "%d shots written to %s in %.1f s (%.1fx real time)\n",
+		(int) detector.getShots().size(), output.toLocal8Bit().constData(),
+		secs, secs > 0 ? videoSecs / secs : 0.0);
+	return 0;
+}
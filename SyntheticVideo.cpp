@@ -0,0 +1,214 @@
+#include <QFile>
+
+#include "SyntheticVideo.h"
+
+const SyntheticVideo::Container SyntheticVideo::_containers[] = {
+	{ "avi", "avi",			ffmpeg::AV_CODEC_ID_MPEG4,		2 },
+	{ "asf", "asf",			ffmpeg::AV_CODEC_ID_MSMPEG4V3,	0 },
+	{ "mpg", "mpeg",		ffmpeg::AV_CODEC_ID_MPEG2VIDEO,	2 },
+	{ "wmv", "asf",			ffmpeg::AV_CODEC_ID_WMV2,		0 },
+	{ "mkv", "matroska",	ffmpeg::AV_CODEC_ID_MPEG4,		2 },
+	{ "mp4", "mp4",			ffmpeg::AV_CODEC_ID_MPEG4,		2 },
+	{ 0, 0, ffmpeg::AV_CODEC_ID_NONE, 0 }
+};
+
+/*! \brief Create the generator
+*
+*	Create a generator of videos of the given size
+*
+*	@param width width of the frames, even
+*	@param height height of the frames, even
+*/
+SyntheticVideo::SyntheticVideo(const int width, const int height) :
+	_width(width & ~1), _height(height & ~1)
+{
+	ffmpeg::avcodec_register_all();
+	ffmpeg::av_register_all();
+}
+
+/*! \brief Destroyer
+*
+*	Destroyer
+*/
+SyntheticVideo::~SyntheticVideo()
+{}
+
+/*! \brief Supported containers
+*
+*	Extensions of the containers a video can be generated in
+*/
+QStringList SyntheticVideo::containers()
+{
+	QStringList list;
+	for (const Container *c = _containers; c->ext; ++c)
+		list << c->ext;
+	return list;
+}
+
+
+/**************************************
+*********    VIDEO ACTIONS    *********
+***************************************/
+
+/*! \brief Write a video
+*
+*	Encode a video in the given container, with its usual codec. The file
+*	is overwritten if it exists and removed if something goes wrong.
+*	@param fileName path of the video
+*	@param container extension of the container, see containers()
+*	@param numFrames number of frames
+*	@return success or not
+*/
+bool SyntheticVideo::write(const QString &fileName, const QString &container, const qint64 numFrames)
+{
+	const Container *c = findContainer(container);
+	if (!c || _width <= 0 || _height <= 0)
+		return false;
+
+	QByteArray path = fileName.toLocal8Bit();
+	ffmpeg::AVFormatContext *fmt = 0;
+	if (ffmpeg::avformat_alloc_output_context2(&fmt, 0, c->format, path.constData()) < 0 || !fmt)
+		return false;
+
+	ffmpeg::AVCodec *codec = ffmpeg::avcodec_find_encoder(c->codec);
+	ffmpeg::AVStream *st = codec ? ffmpeg::avformat_new_stream(fmt, codec) : 0;
+	if (!st) {
+		ffmpeg::avformat_free_context(fmt);
+		return false;
+	}
+
+	ffmpeg::AVRational timeBase = { 1, SYNTH_FPS };
+	ffmpeg::AVCodecContext *ctx = st->codec;
+	ctx->codec_id = c->codec;
+	ctx->width = _width;
+	ctx->height = _height;
+	ctx->time_base = timeBase;
+	ctx->gop_size = SYNTH_GOP;
+	ctx->max_b_frames = c->bFrames;
+	ctx->bit_rate = SYNTH_BITRATE;
+	ctx->pix_fmt = ffmpeg::AV_PIX_FMT_YUV420P;
+	st->time_base = timeBase;
+	if (fmt->oformat->flags & AVFMT_GLOBALHEADER)
+		ctx->flags |= CODEC_FLAG_GLOBAL_HEADER;
+
+	ffmpeg::AVFrame *frame = ffmpeg::av_frame_alloc();
+	bool ok = frame && ffmpeg::avcodec_open2(ctx, codec, 0) >= 0;
+	if (ok) {
+		frame->format = ctx->pix_fmt;
+		frame->width = ctx->width;
+		frame->height = ctx->height;
+		ok = ffmpeg::av_frame_get_buffer(frame, 32) >= 0;
+	}
+	if (ok && !(fmt->oformat->flags & AVFMT_NOFILE))
+		ok = ffmpeg::avio_open(&fmt->pb, path.constData(), AVIO_FLAG_WRITE) >= 0;
+	if (ok)
+		ok = ffmpeg::avformat_write_header(fmt, 0) >= 0;
+	bool headerWritten = ok;
+
+	bool got;
+	for (qint64 num = 0; ok && num < numFrames; ++num) {
+		ok = ffmpeg::av_frame_make_writable(frame) >= 0;
+		if (ok) {
+			drawFrame(frame, num);
+			frame->pts = num;
+			ok = encode(fmt, st, frame, got);
+		}
+	}
+
+	// the frames delayed by the encoder (B frames)
+	got = true;
+	while (ok && got)
+		ok = encode(fmt, st, 0, got);
+
+	if (headerWritten)
+		ok = ffmpeg::av_write_trailer(fmt) >= 0 && ok;
+
+	ffmpeg::av_frame_free(&frame);
+	ffmpeg::avcodec_close(ctx);
+	if (!(fmt->oformat->flags & AVFMT_NOFILE))
+		ffmpeg::avio_closep(&fmt->pb);
+	ffmpeg::avformat_free_context(fmt);
+
+	if (!ok)
+		QFile::remove(fileName);
+	return ok;
+}
+
+
+/**************************************
+************    HELPERS    ************
+***************************************/
+
+/*! \brief Find a container
+*
+*	Find a supported container by its extension
+*	@param ext extension, case insensitive
+*	@return the container, 0 if it's not supported
+*/
+const SyntheticVideo::Container *SyntheticVideo::findContainer(const QString &ext)
+{
+	for (const Container *c = _containers; c->ext; ++c) {
+		if (ext.compare(c->ext, Qt::CaseInsensitive) == 0)
+			return c;
+	}
+	return 0;
+}
+
+/*! \brief Draw a frame
+*
+*	Draw a frame in the YUV planes: a gradient moving with the frame number,
+*	some texture on it and colours that change at each scene.
+*	@param frame the frame, YUV 4:2:0
+*	@param num frame number
+*/
+void SyntheticVideo::drawFrame(ffmpeg::AVFrame *frame, const qint64 num)
+{
+	int scene = num / SYNTH_SCENE_FRAMES;
+	int shift = (int) (num * 3);
+
+	for (int y = 0; y < _height; ++y) {
+		uint8_t *row = frame->data[0] + y * frame->linesize[0];
+		for (int x = 0; x < _width; ++x)
+			row[x] = (uint8_t) (((x + y + shift) & 0xbf) + (((x * 7) ^ (y * 13) ^ scene) & 0x3f));
+	}
+
+	int u = 64 + (scene * 53) % 128;
+	int v = 64 + (scene * 97) % 128;
+	for (int y = 0; y < _height / 2; ++y) {
+		uint8_t *rowU = frame->data[1] + y * frame->linesize[1];
+		uint8_t *rowV = frame->data[2] + y * frame->linesize[2];
+		for (int x = 0; x < _width / 2; ++x) {
+			rowU[x] = (uint8_t) (u + ((x + shift) & 0x1f));
+			rowV[x] = (uint8_t) (v + ((y + shift) & 0x1f));
+		}
+	}
+}
+
+/*! \brief Encode a frame
+*
+*	Give a frame to the encoder and write the packet it gives back, if any
+*	@param fmt output context
+*	@param st video stream
+*	@param frame the frame, 0 to drain the encoder
+*	@param got where it stores whether a packet has been written
+*	@return success or not
+*/
+bool SyntheticVideo::encode(ffmpeg::AVFormatContext *fmt, ffmpeg::AVStream *st, ffmpeg::AVFrame *frame, bool &got)
+{
+	ffmpeg::AVPacket pkt;
+	ffmpeg::av_init_packet(&pkt);
+	pkt.data = 0;
+	pkt.size = 0;
+
+	int gotPacket = 0;
+	got = false;
+	if (ffmpeg::avcodec_encode_video2(st->codec, &pkt, frame, &gotPacket) < 0)
+		return false;
+	if (!gotPacket)
+		return true;
+
+	got = true;
+	ffmpeg::av_packet_rescale_ts(&pkt, st->codec->time_base, st->time_base);
+	pkt.stream_index = st->index;
+	return ffmpeg::av_interleaved_write_frame(fmt, &pkt) >= 0;
+}
@@ -0,0 +1,56 @@
+#ifndef SYNTHETICVIDEO_H
+#define SYNTHETICVIDEO_H
+
+#include <QString>
+#include <QStringList>
+
+#include "ffmpeg.h"
+
+#define SYNTH_FPS			25		// frame rate of the generated videos
+#define SYNTH_GOP			25		// frames between two keyframes
+#define SYNTH_SCENE_FRAMES	75		// frames of each scene, scenes change with a cut
+#define SYNTH_BITRATE		4000000	// bits per second
+
+/*!
+*	@brief Class used to generate test videos
+*
+*	Class used to generate test videos with the ffmpeg libraries, one for each
+*	container the application supports (avi, asf, mpg, wmv, mkv, mp4), each
+*	with the codec usually found in it.
+*	Frames are drawn directly in YUV: a moving gradient with some texture,
+*	so the encoder can't reduce them to nothing, whose colours change with
+*	a cut every few seconds. The content only depends on the frame number,
+*	so the same settings always give the same video.
+*/
+class SyntheticVideo
+{
+	//! Container and codec of a kind of video
+	struct Container {
+		const char				*ext;		//!< file extension
+		const char				*format;	//!< ffmpeg muxer
+		ffmpeg::AVCodecID		codec;
+		int						bFrames;	//!< max consecutive B frames
+	};
+
+	static const Container	_containers[];	//!< supported containers, ended by a null one
+
+	int		_width;
+	int		_height;
+
+	//  Helpers
+	static const Container *findContainer(const QString &ext);
+	void	drawFrame(ffmpeg::AVFrame *frame, const qint64 num);
+	bool	encode(ffmpeg::AVFormatContext *fmt, ffmpeg::AVStream *st, ffmpeg::AVFrame *frame, bool &got);
+
+public:
+
+	SyntheticVideo(const int width, const int height);
+	~SyntheticVideo();
+
+	//  Video actions
+	bool	write(const QString &fileName, const QString &container, const qint64 numFrames);
+
+	static QStringList containers();
+};
+
+#endif // SYNTHETICVIDEO_H
@@ -0,0 +1,404 @@
+#include <QDir>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QBuffer>
+#include <QDebug>
+#include <cstring>
+
+#include "ThumbnailStore.h"
+
+#define THUMBSTORE_MAGIC	0x534d5450	// "SMTP"
+#define THUMBSTORE_VERSION	2			// 2: frames numbered on the timeline
+#define THUMBSTORE_HEADER	8			// magic and version, native byte order
+#define THUMBSTORE_RECORD	12			// key and size of each record
+
+/*! \brief Create the store
+*
+*	Create the store and open its pack file, creating it if needed. When
+*	another instance of the application holds the pack it's opened read only.
+*
+*	@param path path of the pack file
+*	@param maxBytes max size of the pack file
+*/
+ThumbnailStore::ThumbnailStore(const QString &path, const qint64 maxBytes) :
+	_lock(path + ".lock"), _maxBytes(maxBytes), _file(path)
+{
+	_map = 0;
+	_mapped = 0;
+	_quit = false;
+	_readOnly = !_lock.tryLock(0);
+
+	if (!openPack())
+		qDebug() << "Thumbnails store not available:" << path;
+	else if (!_readOnly)
+		start(QThread::LowPriority);
+}
+
+/*! \brief Destroyer
+*
+*	Store the thumbnails still queued, unmap and close the pack file and
+*	release it to the other instances
+*/
+ThumbnailStore::~ThumbnailStore()
+{
+	_mutex.lock();
+	_quit = true;
+	_queueCond.wakeOne();
+	_mutex.unlock();
+
+	wait();
+
+	if (_map)
+		_file.unmap(_map);
+	_file.close();
+}
+
+/*! \brief Worker loop
+*
+*	Compress the queued thumbnails and append them to the pack. The
+*	compression doesn't hold the lock, lookups go on meanwhile.
+*/
+void ThumbnailStore::run()
+{
+	forever {
+		_mutex.lock();
+		while (_queue.isEmpty() && !_quit)
+			_queueCond.wait(&_mutex);
+		if (_queue.isEmpty()) {
+			_mutex.unlock();
+			return;
+		}
+		Pending p = _queue.takeFirst();
+		_mutex.unlock();
+
+		QByteArray jpeg;
+		QBuffer buffer(&jpeg);
+		buffer.open(QIODevice::WriteOnly);
+		if (!p.img.save(&buffer, "JPG", THUMBSTORE_QUALITY))
+			continue;
+
+		QMutexLocker locker(&_mutex);
+		append(p.key, jpeg);
+	}
+}
+
+/*! \brief Default path of the pack file
+*
+*	Path of the pack file in the cache folder of the application
+*/
+QString ThumbnailStore::defaultPath()
+{
+	QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+	QDir().mkpath(dir);
+	return dir + "/thumbnails.smpack";
+}
+
+
+/**************************************
+*********    STORE ACTIONS    *********
+***************************************/
+
+/*! \brief Set the current video
+*
+*	Set the video the thumbnails belong to, hashing its size and the
+*	beginning and the end of its content.
+*	@param fileName path of the video
+*	@return success or not
+*/
+bool ThumbnailStore::setVideo(const QString &fileName)
+{
+	_video = QByteArray();
+
+	QFile video(fileName);
+	if (!video.open(QIODevice::ReadOnly))
+		return false;
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	qint64 size = video.size();
+	hash.addData((const char *) &size, sizeof(size));
+	hash.addData(video.read(THUMBSTORE_SAMPLE));
+	if (size > THUMBSTORE_SAMPLE) {
+		video.seek(qMax((qint64) THUMBSTORE_SAMPLE, size - THUMBSTORE_SAMPLE));
+		hash.addData(video.read(THUMBSTORE_SAMPLE));
+	}
+	_video = hash.result();
+	return true;
+}
+
+/*! \brief Get a thumbnail
+*
+*	Get a thumbnail of the current video stored before
+*	@param num frame number
+*	@param size box the thumbnail fits in
+*	@param img where the thumbnail will be stored
+*	@return found or not
+*/
+bool ThumbnailStore::get(const qint64 num, const QSize &size, QImage &img)
+{
+	if (_video.isEmpty())
+		return false;
+
+	const quint64 k = key(num, size);
+	QByteArray jpeg;
+
+	_mutex.lock();
+	QHash<quint64, Record>::const_iterator it = _records.constFind(k);
+	bool ok = _file.isOpen() && it != _records.constEnd();
+	if (ok && _readOnly) {
+		// the owner of the pack may have emptied it and written other records
+		const Record r = it.value();
+		quint64 stored;
+		qint32 bytes;
+		ok = readHead(r.offset - THUMBSTORE_RECORD, stored, bytes) && stored == k && bytes == r.bytes;
+		if (ok)
+			jpeg = _file.read(r.bytes);
+		ok = ok && jpeg.size() == r.bytes;
+		if (!ok)
+			_records.remove(k);
+	}
+	else if (ok) {
+		// appended after the last mapping? the copy is decompressed without
+		// the lock, a reset can unmap the pack meanwhile
+		const Record r = it.value();
+		ok = r.offset + r.bytes <= _mapped || remap();
+		if (ok)
+			jpeg = QByteArray((const char *) _map + r.offset, r.bytes);
+	}
+	_mutex.unlock();
+
+	if (!ok || !img.loadFromData(jpeg, "JPG"))
+		return false;
+	if (img.format() != QImage::Format_RGB32)
+		img = img.convertToFormat(QImage::Format_RGB32);
+	return true;
+}
+
+/*! \brief Store a thumbnail
+*
+*	Queue a thumbnail of the current video, the thread of the store
+*	compresses it as jpeg and appends it. Nothing is stored when the pack is
+*	read only or too many thumbnails are waiting.
+*	@param num frame number
+*	@param size box the thumbnail fits in
+*	@param img the thumbnail, shared with the caller
+*/
+void ThumbnailStore::put(const qint64 num, const QSize &size, const QImage &img)
+{
+	if (_video.isEmpty() || _readOnly || img.isNull())
+		return;
+
+	Pending p;
+	p.key = key(num, size);
+	p.img = img;
+
+	QMutexLocker locker(&_mutex);
+	if (!_file.isOpen() || _records.contains(p.key) || _queue.size() >= THUMBSTORE_MAX_QUEUE)
+		return;
+	for (const Pending &q : _queue) {
+		if (q.key == p.key)
+			return;
+	}
+	_queue.append(p);
+	_queueCond.wakeOne();
+}
+
+
+/**************************************
+************    HELPERS    ************
+***************************************/
+
+/*! \brief Append a thumbnail
+*
+*	Append a compressed thumbnail to the pack, must be called with the mutex
+*	locked.
+*	@param k key of the thumbnail
+*	@param jpeg compressed thumbnail
+*/
+void ThumbnailStore::append(const quint64 k, const QByteArray &jpeg)
+{
+	if (!_file.isOpen() || _records.contains(k))
+		return;
+
+	// full: start over, the thumbnails of the videos reopened are made again
+	qint64 end = _file.size();
+	if (end + THUMBSTORE_RECORD + jpeg.size() > _maxBytes) {
+		reset();
+		end = _file.size();
+	}
+
+	char head[THUMBSTORE_RECORD];
+	qint32 bytes = jpeg.size();
+	memcpy(head, &k, sizeof(k));
+	memcpy(head + sizeof(k), &bytes, sizeof(bytes));
+
+	if (
+		!_file.seek(end) || _file.write(head, THUMBSTORE_RECORD) != THUMBSTORE_RECORD ||
+		_file.write(jpeg) != jpeg.size()
+	) {
+		_file.resize(end);
+		return;
+	}
+
+	Record r;
+	r.offset = end + THUMBSTORE_RECORD;
+	r.bytes = bytes;
+	_records.insert(k, r);
+}
+
+/*! \brief Open the pack file
+*
+*	Open the pack file, or create it, and read the keys of its records. The
+*	owner of the pack drops a record cut by a crash and anything after it,
+*	and maps the pack.
+*	@return success or not
+*/
+bool ThumbnailStore::openPack()
+{
+	if (!_file.open(_readOnly ? QIODevice::ReadOnly : QIODevice::ReadWrite))
+		return false;
+
+	char head[THUMBSTORE_HEADER];
+	quint32 magic = 0, version = 0;
+	if (_file.read(head, THUMBSTORE_HEADER) == THUMBSTORE_HEADER) {
+		memcpy(&magic, head, sizeof(magic));
+		memcpy(&version, head + sizeof(magic), sizeof(version));
+	}
+	if (magic != THUMBSTORE_MAGIC || version != THUMBSTORE_VERSION) {
+		if (!_readOnly)
+			reset();
+		return _file.isOpen();
+	}
+
+	const qint64 end = _file.size();
+	qint64 pos = THUMBSTORE_HEADER;
+	while (pos + THUMBSTORE_RECORD <= end) {
+		quint64 k;
+		qint32 bytes;
+		if (!readHead(pos, k, bytes) || bytes <= 0 || pos + THUMBSTORE_RECORD + bytes > end)
+			break;
+
+		Record r;
+		r.offset = pos + THUMBSTORE_RECORD;
+		r.bytes = bytes;
+		_records.insert(k, r);
+		pos = r.offset + bytes;
+	}
+	if (_readOnly)
+		return true;
+
+	if (pos != end)
+		_file.resize(pos);
+	return remap();
+}
+
+/*! \brief Read the head of a record
+*
+*	Read key and size of the record at the given position of the pack
+*	@param pos position of the record
+*	@param k where the key will be stored
+*	@param bytes where the size of the jpeg data will be stored
+*	@return success or not
+*/
+bool ThumbnailStore::readHead(const qint64 pos, quint64 &k, qint32 &bytes)
+{
+	char head[THUMBSTORE_RECORD];
+	if (!_file.seek(pos) || _file.read(head, THUMBSTORE_RECORD) != THUMBSTORE_RECORD)
+		return false;
+
+	memcpy(&k, head, sizeof(k));
+	memcpy(&bytes, head + sizeof(k), sizeof(bytes));
+	return true;
+}
+
+/*! \brief Map the pack file
+*
+*	Map the whole pack file again, after records have been appended
+*	@return success or not
+*/
+bool ThumbnailStore::remap()
+{
+	if (_map)
+		_file.unmap(_map);
+	_file.flush();
+	_mapped = _file.size();
+	_map = _file.map(0, _mapped);
+	if (!_map)
+		_mapped = 0;
+	return _map != 0;
+}
+
+/*! \brief Empty the pack file
+*
+*	Drop all the thumbnails, only the header is left
+*/
+void ThumbnailStore::reset()
+{
+	if (_map)
+		_file.unmap(_map);
+	_map = 0;
+	_mapped = 0;
+	_records.clear();
+
+	char head[THUMBSTORE_HEADER];
+	quint32 magic = THUMBSTORE_MAGIC, version = THUMBSTORE_VERSION;
+	memcpy(head, &magic, sizeof(magic));
+	memcpy(head + sizeof(magic), &version, sizeof(version));
+
+	if (!_file.resize(0) || !_file.seek(0) || _file.write(head, THUMBSTORE_HEADER) != THUMBSTORE_HEADER)
+		_file.close();
+}
+
+/*! \brief Key of a thumbnail
+*
+*	Key of a thumbnail of the current video
+*	@param num frame number
+*	@param size box the thumbnail fits in
+*/
+quint64 ThumbnailStore::key(const qint64 num, const QSize &size)
+{
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	qint32 w = size.width(), h = size.height();
+	hash.addData(_video);
+	hash.addData((const char *) &num, sizeof(num));
+	hash.addData((const char *) &w, sizeof(w));
+	hash.addData((const char *) &h, sizeof(h));
+
+	quint64 k;
+	memcpy(&k, hash.result().constData(), sizeof(k));
+	return k;
+}
+
+
+/**************************************
+*********        GETTERS      *********
+***************************************/
+
+/*! \brief the store is usable?
+*
+*	The pack file is open
+*/
+bool ThumbnailStore::isOpen()
+{
+	QMutexLocker locker(&_mutex);
+	return _file.isOpen();
+}
+
+/*! \brief the store only reads?
+*
+*	Another instance of the application writes the pack, the thumbnails
+*	given aren't stored
+*/
+bool ThumbnailStore::isReadOnly()
+{
+	return _readOnly;
+}
+
+/*! \brief Get number of thumbnails
+*
+*	Retrieve the number of thumbnails in the pack file
+*/
+int ThumbnailStore::size()
+{
+	QMutexLocker locker(&_mutex);
+	return _records.size();
+}
@@ -0,0 +1,94 @@
+#ifndef THUMBNAILSTORE_H
+#define THUMBNAILSTORE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QLockFile>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QImage>
+
+#define THUMBSTORE_MAX_BYTES	((qint64) 512 * 1024 * 1024)	// 512 MB
+#define THUMBSTORE_QUALITY		85				// jpeg quality of the thumbnails
+#define THUMBSTORE_SAMPLE		(1024 * 1024)	// bytes hashed at each end of a video
+#define THUMBSTORE_MAX_QUEUE	256				// thumbnails waiting to be stored, more are dropped
+
+/*!
+*	@brief Class used to keep thumbnails across sessions
+*
+*	Class used to keep thumbnails across sessions, so a video opened again
+*	shows its previews without decoding them.
+*	All the thumbnails of all the videos are appended, as jpeg, to a single
+*	pack file in the cache folder of the application, which is memory mapped:
+*	looking a thumbnail up costs a hash lookup and a jpeg decompression.
+*	Thumbnails are addressed by the content of the video (a hash of its size
+*	and of its first and last MB, so a video copied or renamed is still found),
+*	the frame number and the thumbnail size.
+*	When the pack reaches its max size it's emptied and starts over.
+*	The thumbnails given are compressed and appended by the thread of the
+*	store, the lookups don't wait for them. Only one running instance of the
+*	application writes the pack, the one holding the lock file next to it:
+*	the others read it without mapping it and check each record, the owner
+*	could have emptied the pack meanwhile.
+*	It must be used by a single thread.
+*/
+class ThumbnailStore : public QThread
+{
+	//! Thumbnail in the pack file
+	struct Record {
+		qint64	offset;		//!< position of the jpeg data
+		qint32	bytes;		//!< size of the jpeg data
+	};
+
+	//! Thumbnail waiting to be compressed and appended
+	struct Pending {
+		quint64	key;
+		QImage	img;
+	};
+
+	QLockFile				_lock;		//!< held by the instance that writes the pack
+	bool					_readOnly;	//!< another instance writes the pack
+	qint64					_maxBytes;	//!< max size of the pack file
+	QByteArray				_video;		//!< content hash of the current video
+
+	QMutex					_mutex;		//!< protects all the variables below
+	QWaitCondition			_queueCond;	//!< a thumbnail to store or quit
+	QFile					_file;		//!< pack file
+	uchar					*_map;		//!< mapped pack file, not when read only
+	qint64					_mapped;	//!< bytes mapped
+	QHash<quint64, Record>	_records;	//!< thumbnails by key
+	QList<Pending>			_queue;		//!< thumbnails to store
+	bool					_quit;		//!< stop the thread once the queue is empty
+
+	//  Helpers
+	bool	openPack();
+	bool	readHead(const qint64 pos, quint64 &k, qint32 &bytes);
+	bool	remap();
+	void	reset();
+	void	append(const quint64 k, const QByteArray &jpeg);
+	quint64	key(const qint64 num, const QSize &size);
+
+protected:
+	void run();
+
+public:
+
+	ThumbnailStore(const QString &path = defaultPath(), const qint64 maxBytes = THUMBSTORE_MAX_BYTES);
+	~ThumbnailStore();
+
+	//  Store actions
+	bool	setVideo(const QString &fileName);
+	bool	get(const qint64 num, const QSize &size, QImage &img);
+	void	put(const qint64 num, const QSize &size, const QImage &img);
+
+	//  Getters
+	bool	isOpen();
+	bool	isReadOnly();
+	int		size();
+
+	static QString defaultPath();
+};
+
+#endif // THUMBNAILSTORE_H
@@ -0,0 +1,160 @@
+#include <cmath>
+#include <algorithm>
+
+#include "Timeline.h"
+
+static const ffmpeg::AVRational millisecondbase = { 1, 1000 };
+
+/*! \brief Create an empty timeline
+*
+*	Create an empty timeline
+*/
+Timeline::Timeline()
+{
+	clear();
+}
+
+/*! \brief Destroyer
+*
+*	Destroyer
+*/
+Timeline::~Timeline()
+{}
+
+
+/**************************************
+********    TIMELINE ACTIONS    *******
+***************************************/
+
+/*! \brief Build the timeline of a video
+*
+*	Collect the presentation timestamps of all the packets of the index and
+*	sort them. A packet without timestamps is placed one packet duration
+*	after the previous one.
+*	@param index packets index of the video stream
+*	@param timeBase time base of the video stream
+*	@return success or not
+*/
+bool Timeline::build(FrameIndex &index, const ffmpeg::AVRational timeBase)
+{
+	clear();
+	if (!index.isValid())
+		return false;
+
+	_timeBase = timeBase;
+	_ts.reserve(index.size());
+
+	qint64 last = 0;
+	for (int i = 0; i < index.size(); ++i) {
+		const FrameIndexEntry &e = index.at(i);
+		if (e.pts != AV_NOPTS_VALUE)
+			last = e.pts;
+		else if (e.dts != AV_NOPTS_VALUE)
+			last = e.dts;
+		else
+			last += e.duration;
+		_ts.push_back(last);
+
+		// the last frame shown is not always the last packet (B-frames)
+		_end = qMax(_end, last + e.duration);
+	}
+	std::sort(_ts.begin(), _ts.end());
+	_end = qMax(_end, _ts.back());
+	return true;
+}
+
+/*! \brief Clear the timeline
+*
+*	Clear the timeline
+*/
+void Timeline::clear()
+{
+	_ts.clear();
+	_end = INT64_MIN;
+	_timeBase = { 0, 1 };
+}
+
+
+/**************************************
+***********    MAPPING    *************
+***************************************/
+
+/*! \brief Timestamp of a frame
+*
+*	Presentation timestamp of a frame, in stream time base
+*	@param num frame number, clamped to the video
+*/
+qint64 Timeline::frameTs(const qint64 num)
+{
+	return _ts[qBound((qint64) 0, num, numFrames() - 1)];
+}
+
+/*! \brief Time of a frame
+*
+*	Time of a frame from the first one
+*	@param num frame number, clamped to the video
+*	@return time in milliseconds
+*/
+qint64 Timeline::frameTime(const qint64 num)
+{
+	return ffmpeg::av_rescale_q(frameTs(num) - _ts.front(), _timeBase, millisecondbase);
+}
+
+/*! \brief Frame of a timestamp
+*
+*	Binary search of the frame shown at the given timestamp, the last one
+*	whose timestamp is <= ts
+*	@param ts timestamp in stream time base
+*	@return frame number, 0 if ts precedes all the frames
+*/
+qint64 Timeline::frameAtTs(const qint64 ts)
+{
+	qint64 i = std::upper_bound(_ts.begin(), _ts.end(), ts) - _ts.begin();
+	return qMax((qint64) 0, i - 1);
+}
+
+/*! \brief Frame of a time
+*
+*	Frame shown at the given time
+*	@param ms time from the first frame in milliseconds
+*	@return frame number
+*/
+qint64 Timeline::frameAtTime(const qint64 ms)
+{
+	return frameAtTs(_ts.front() + ffmpeg::av_rescale_q(ms, millisecondbase, _timeBase));
+}
+
+
+/**************************************
+*********        GETTERS      *********
+***************************************/
+
+/*! \brief The timeline is usable?
+*
+*	The timeline contains at least a frame
+*/
+bool Timeline::isValid()
+{
+	return !_ts.empty();
+}
+
+/*! \brief Get number of frames
+*
+*	Retrieve the exact number of frames of the video
+*/
+qint64 Timeline::numFrames()
+{
+	return _ts.size();
+}
+
+/*! \brief Get the video length
+*
+*	Retrieve the time from the first frame to the end of the last one
+*	@return length in milliseconds
+*/
+qint64 Timeline::getLengthMs()
+{
+	if (!isValid())
+		return 0;
+	return ffmpeg::av_rescale_q(_end - _ts.front(), _timeBase, millisecondbase);
+}
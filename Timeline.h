@@ -0,0 +1,48 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <vector>
+
+#include "FrameIndex.h"
+
+/*!
+*	@brief Class used to map frame numbers to times and back
+*
+*	Class used to map frame numbers to times and back, from the real
+*	timestamps of the frames instead of a constant frame rate.
+*	It is built from the packets index: the presentation timestamps of all
+*	the video packets, sorted, are the timestamps of the frames in the order
+*	they are shown, so the n-th one is the timestamp of frame n. Frame to time
+*	is a lookup, time to frame a binary search; both stay exact with a
+*	variable frame rate (phone footage, screen recordings), where
+*	time / frame ms drifts.
+*	Times are in milliseconds from the first frame.
+*/
+class Timeline
+{
+	std::vector<qint64>	_ts;		//!< frames timestamps, in presentation order
+	qint64				_end;		//!< timestamp where the last frame ends
+	ffmpeg::AVRational	_timeBase;	//!< time base of the timestamps
+
+public:
+
+	Timeline();
+	~Timeline();
+
+	//  Timeline actions
+	bool	build(FrameIndex &index, const ffmpeg::AVRational timeBase);
+	void	clear();
+
+	//  Mapping
+	qint64	frameTs(const qint64 num);
+	qint64	frameTime(const qint64 num);
+	qint64	frameAtTs(const qint64 ts);
+	qint64	frameAtTime(const qint64 ms);
+
+	//  Getters
+	bool	isValid();
+	qint64	numFrames();
+	qint64	getLengthMs();
+};
+
+#endif // TIMELINE_H
@@ -0,0 +1,139 @@
+#include <QPainter>
+#include <QPaintEvent>
+
+#include "VideoSurface.h"
+#include "Profiler.h"
+
+/*! \brief Create the surface
+*
+*	Create an empty surface
+*
+*	@param parent parent
+*/
+VideoSurface::VideoSurface(QWidget *parent) : QWidget(parent)
+{
+	_scaledKey = 0;
+	_fast = false;
+	setMinimumSize(1, 1);
+	setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+}
+
+/*! \brief Destroyer
+*
+*	Destroyer
+*/
+VideoSurface::~VideoSurface()
+{}
+
+/*! \brief Paint the frame
+*
+*	Paint the frame centered in the widget, fitted keeping its aspect ratio
+*	@param e paint event
+*/
+void VideoSurface::paintEvent(QPaintEvent *)
+{
+	PROFILE_SCOPE("paint");
+
+	QPainter painter(this);
+	if (_frame.isNull()) {
+		if (!_text.isEmpty()) {
+			painter.setPen(palette().color(QPalette::WindowText));
+			painter.drawText(rect(), Qt::AlignCenter, _text);
+		}
+		return;
+	}
+
+	QRect target = targetRect();
+
+	// playing: each frame is shown once, a scaled copy would be wasted
+	if (_fast || target.size() == _frame.size()) {
+		painter.drawImage(target, _frame);
+		return;
+	}
+
+	// still: scale smoothly once for each size
+	if (_scaledKey != _frame.cacheKey() || _scaled.size() != target.size()) {
+		PROFILE_SCOPE("smooth scale");
+		_scaled = _frame.scaled(target.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+		_scaledKey = _frame.cacheKey();
+	}
+	painter.drawImage(target.topLeft(), _scaled);
+}
+
+
+/**************************************
+*********    FRAME ACTIONS    *********
+***************************************/
+
+/*! \brief show a frame
+*
+*	Show a frame, it's painted at the next repaint
+*	@param frame the frame
+*/
+void VideoSurface::setFrame(const QImage &frame)
+{
+	_frame = frame;
+	_text.clear();
+	update();
+}
+
+/*! \brief show a text
+*
+*	Show a text instead of a frame, e.g. while the frame is decoded
+*	@param text the text
+*/
+void VideoSurface::setText(const QString &text)
+{
+	_frame = QImage();
+	_scaled = QImage();
+	_scaledKey = 0;
+	_text = text;
+	update();
+}
+
+/*! \brief clear the surface
+*
+*	Drop the frame shown and its scaled copy
+*/
+void VideoSurface::clear()
+{
+	_frame = QImage();
+	_scaled = QImage();
+	_scaledKey = 0;
+	_text.clear();
+	update();
+}
+
+/*! \brief fast scaling
+*
+*	Scale the frames fast, e.g. while playing, or smoothly. The frame shown
+*	is repainted with the new quality.
+*	@param enable fast or smooth
+*/
+void VideoSurface::setFastScaling(const bool enable)
+{
+	if (_fast == enable)
+		return;
+	_fast = enable;
+	if (!enable)
+		_scaled = QImage();
+	update();
+}
+
+
+/**************************************
+************    HELPERS    ************
+***************************************/
+
+/*! \brief Rectangle of the frame
+*
+*	Rectangle where the frame is painted: as big as the widget allows
+*	keeping the aspect ratio of the frame, centered.
+*/
+QRect VideoSurface::targetRect()
+{
+	QSize size = _frame.size().scaled(this->size(), Qt::KeepAspectRatio);
+	QRect target(QPoint(0, 0), size);
+	target.moveCenter(rect().center());
+	return target;
+}
@@ -0,0 +1,50 @@
+#ifndef VIDEOSURFACE_H
+#define VIDEOSURFACE_H
+
+#include <QWidget>
+#include <QImage>
+
+/*!
+*	@brief Widget used to paint the video frames
+*
+*	Widget used to paint the video frames, scaled to fit it keeping their
+*	aspect ratio.
+*	Frames are scaled only when painted: during the playback they are blitted
+*	straight to the target rectangle with a fast scaling, so no scaled copy
+*	is made for frames shown once. A still frame is scaled smoothly once for
+*	each size and the scaled copy is kept, so repainting it (e.g. when the
+*	window is exposed) costs a plain blit, and a frame already of the size
+*	of its rectangle (e.g. a thumbnail) is never scaled.
+*	Frames are the shared QImage of the decoded frames, painted directly:
+*	setting one doesn't copy it and no QPixmap is built.
+*	When there is no frame a short text can be shown instead.
+*/
+class VideoSurface : public QWidget
+{
+	Q_OBJECT
+
+	QImage		_frame;		//!< frame shown
+	QImage		_scaled;	//!< frame smoothly scaled to the last size painted
+	QString		_text;		//!< shown when there is no frame
+	qint64		_scaledKey;	//!< cacheKey of the frame that has been scaled
+	bool		_fast;		//!< fast scaling, while playing
+
+	//  Helpers
+	QRect	targetRect();
+
+protected:
+	void paintEvent(QPaintEvent *e);
+
+public:
+
+	explicit VideoSurface(QWidget *parent = 0);
+	~VideoSurface();
+
+	//  Frame actions
+	void	setFrame(const QImage &frame);
+	void	setText(const QString &text);
+	void	clear();
+	void	setFastScaling(const bool enable);
+};
+
+#endif // VIDEOSURFACE_H
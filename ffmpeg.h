@@ -38,6 +38,7 @@ namespace ffmpeg {
 		#include "libavformat/avformat.h"
 		//#include "libavutil/mathematics.h"
 		#include "libavutil/rational.h"
+		#include "libavutil/pixdesc.h"
 		//#include "libavutil/avutil.h"
 		//#include "libavutil/avstring.h"
 		//#include "libavutil/dict.h"
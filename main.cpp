@@ -13,6 +13,7 @@
 
 #include <QtWidgets/QApplication>
 #include "mainwindow.h"
+#include "Profiler.h"
 
 int main(int argc, char *argv[])
 {
@@ -20,5 +21,12 @@ int main(int argc, char *argv[])
 	 MainWindow w;
 	 w.setWindowFlags(Qt::Widget | Qt::FramelessWindowHint);// | Qt::X11BypassWindowManagerHint);
 	 w.show();
-	 return a.exec();
+	 int ret = a.exec();
+
+#ifdef PROFILING
+	 QString dump = Profiler::defaultDumpPath();
+	 if (Profiler::instance().dump(dump))
+		 qDebug() << "Timings written to" << dump;
+#endif
+	 return ret;
 }
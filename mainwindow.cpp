@@ -83,9 +83,19 @@ MainWindow::MainWindow(QWidget *parent) :
 
 	ui->previewsLayout->addWidget(_prevWidg);
 
+	// the label shows the instructions until a video is loaded
+	_videoSurface = new VideoSurface(ui->playerWidget);
+	ui->verticalLayout_5->insertWidget(0, _videoSurface);
+	_videoSurface->hide();
+
+#ifdef PROFILING
+	// timings of the hot paths over the video, toggled from the menu
+	_profilerOverlay = new ProfilerOverlay(ui->playerWidget);
+	connect(menubar->actionTimings, SIGNAL(toggled(bool)), _profilerOverlay, SLOT(setShown(bool)));
+#endif
+
 	sliderPageStep = ui->videoSlider->pageStep();
 	sliderMaxVal = ui->videoSlider->maximum() + 1;
-	ui->labelVideoFrame->setMinimumSize(1,1);
 
 	ui->progressLbl->setText("Started");
 
@@ -268,7 +278,6 @@ void MainWindow::changeEvent(QEvent *e)
 void MainWindow::resizeEvent(QResizeEvent *e)
 {
 	QMainWindow::resizeEvent(e);
-	_playerWidg->reloadFrame();
 	_prevWidg->reloadLayout();
 }
 
@@ -295,6 +304,9 @@ void MainWindow::initializeIcons() {
 */
 void MainWindow::updateSlider()
 {
+	// don't pull the slider from under the mouse while scrubbing
+	if (ui->videoSlider->isSliderDown())
+		return;
 	ui->videoSlider->setValue(round(_playerWidg->currentTimePercentage() * sliderMaxVal));
 }
 
@@ -313,25 +325,21 @@ void MainWindow::changePlayPause(bool playState)
 		ui->playPauseBtn->setToolTip("Play");
 		ui->playPauseBtn->setIcon(QIcon(playIcon));
 	}
+
+	// the smooth scaling costs too much for every frame of the playback
+	_videoSurface->setFastScaling(playState);
 }
 
 /*! \brief Update the frame image.
 *
-*	Draw the new frame image in the proper label.
+*	Show the new frame image in the video surface, which scales it when
+*	painting. The image is shared with the buffer, not copied.
 *	
-*	@param p qpixmap image
+*	@param f the frame
 */
-void MainWindow::updateFrame(QPixmap p)
-{
-	// set a scaled pixmap to a w x h window keeping its aspect ratio
-	ui->labelVideoFrame->setPixmap(
-		p.scaled(
-			ui->labelVideoFrame->width(),
-			ui->labelVideoFrame->height(),
-			Qt::KeepAspectRatio,
-			Qt::SmoothTransformation
-		)
-	);
+void MainWindow::updateFrame(const Frame &f)
+{
+	_videoSurface->setFrame(f.img);
 }
 
 /*! \brief Update the time box.
@@ -376,6 +384,33 @@ void MainWindow::endOfStream()
 	_prevWidg->reloadAndDrawPreviews(_playerWidg->currentFrameNumber());
 }
 
+/*! \brief Signal that the player shows the frame of the last seek
+*
+*	Signal that the player shows the frame of the last seek, the previews
+*	follow it once the slider is released
+*	
+*/
+void MainWindow::seekFinished()
+{
+	if (!ui->videoSlider->isSliderDown())
+		_prevWidg->reloadAndDrawPreviews(_playerWidg->currentFrameNumber());
+	updateProgressText("");
+}
+
+/*! \brief The frame numbers are final
+*
+*	Called when the video has been indexed: the frames have been renumbered,
+*	so the previews are reloaded and the markers can be set.
+*/
+void MainWindow::indexChanged()
+{
+	_prevWidg->reloadAndDrawPreviews(_playerWidg->currentFrameNumber());
+	if (!ui->markersTableWidget->isEnabled()) {
+		enableMarkers(true);
+		updateProgressText("Video indexed");
+	}
+}
+
 /*! \brief Seek to the wanted frame number
 *
 *	Seek to the wanted frame number
@@ -392,6 +427,18 @@ void MainWindow::jumpToFrame(const qint64 num)
 	_prevWidg->reloadAndDrawPreviews(num);
 }
 
+/*! \brief Keep in memory the frames around the given ones
+*
+*	Keep in memory the frames around the given ones (the markers boundaries)
+*	so that jumping to them doesn't decode anything
+*	
+*	@param nums frame numbers
+*/
+void MainWindow::pinFrames(const QList<qint64> nums)
+{
+	_bmng->pinFrames(nums);
+}
+
 /*! \brief Properly change start/end markers button icons and tooltip
 *
 *	Properly change start/end markers button icons and tooltip
@@ -453,6 +500,20 @@ void MainWindow::changeMarkersFileUI(const bool state)
 	}
 }
 
+/*! \brief Enable or disable the markers
+*
+*	Enable or disable setting, editing and jumping to the markers: while
+*	the video is being indexed the frame numbers aren't final.
+*
+*	@param enable markers usable or not
+*/
+void MainWindow::enableMarkers(const bool enable)
+{
+	ui->startMarkerBtn->setEnabled(enable);
+	ui->endMarkerBtn->setEnabled(enable);
+	ui->markersTableWidget->setEnabled(enable);
+}
+
 
 /**********************************************
 ******************** ACTIONS ******************
@@ -473,8 +534,12 @@ void MainWindow::on_actionLoad_video_triggered()
 		ui->videoSlider->setValue(0);
 		_playerWidg->loadVideo(fileName);
 		_prevWidg->setupPreviews();
+		ui->labelVideoFrame->hide();
+		_videoSurface->show();
 		ui->subplayerWidget->show();
-		updateProgressText("Video loaded");
+		// frame numbers are predicted until the video is indexed
+		enableMarkers(!_bmng->isIndexPending());
+		updateProgressText(_bmng->isIndexPending() ? "Video loaded, indexing" : "Video loaded");
 	}
 }
 
@@ -570,9 +635,13 @@ void MainWindow::on_videoSlider_actionTriggered(int action)
 		if (val >= sliderMaxVal)
 			val = sliderMaxVal - 1;
 		updateProgressText("Seeking to desired position..");
-		_playerWidg->seekToTimePercentage(val / (double)sliderMaxVal);
-		_prevWidg->reloadAndDrawPreviews(_playerWidg->currentFrameNumber());
-		updateProgressText("");
+		_playerWidg->requestSeekToTimePercentage(val / (double)sliderMaxVal);
+	}
+	// dragging, the frames follow the slider without waiting for the decoder
+	else if (action == QAbstractSlider::SliderMove) {
+		if (!_playerWidg->isVideoLoaded())
+			return;
+		_playerWidg->requestSeekToTimePercentage(ui->videoSlider->sliderPosition() / (double)sliderMaxVal);
 	}
 }
 
@@ -583,9 +652,7 @@ void MainWindow::on_videoSlider_sliderReleased()
 		return;
 	}
 	updateProgressText("Seeking to desired position..");
-	_playerWidg->seekToTimePercentage(ui->videoSlider->value() / (double)sliderMaxVal);
-	_prevWidg->reloadAndDrawPreviews(_playerWidg->currentFrameNumber());
-	updateProgressText("");
+	_playerWidg->requestSeekToTimePercentage(ui->videoSlider->value() / (double)sliderMaxVal);
 }
 
 
@@ -615,6 +682,9 @@ void MainWindow::on_splitter_2_splitterMoved(int pos, int index)
 /***  MARKERS  ***/
 void MainWindow::on_startMarkerBtn_clicked()
 {
+	// from the menu too
+	if (!ui->startMarkerBtn->isEnabled())
+		return;
 	qint64 frameNum = _playerWidg->currentFrameNumber();
 	if (_markersWidg->_markerStarted) {// end + start
 		_markersWidg->endAndStartMarker(frameNum, frameNum + 1);
@@ -627,6 +697,8 @@ void MainWindow::on_startMarkerBtn_clicked()
 
 void MainWindow::on_endMarkerBtn_clicked()
 {
+	if (!ui->endMarkerBtn->isEnabled())
+		return;
 	_markersWidg->endAndStartMarker(_playerWidg->currentFrameNumber(), -1);
 	changeMarkersFileUI(true);
 }
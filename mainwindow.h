@@ -9,6 +9,10 @@
 
 #include "TitleBar.h"
 #include "PlayerWidget.h"
+#include "VideoSurface.h"
+#ifdef PROFILING
+#include "ProfilerOverlay.h"
+#endif
 #include "PreviewsWidget.h"
 #include "MarkersWidget.h"
 #include "CompareMarkersDialog.h"
@@ -41,6 +45,10 @@ protected:
 	ImagesBuffer *_bmng;
 	MarkersWidget *_markersWidg;
 	CompareMarkersDialog *_dial;
+	VideoSurface *_videoSurface;
+#ifdef PROFILING
+	ProfilerOverlay *_profilerOverlay;
+#endif
 
 	TitleBar *titlebar;
 
@@ -75,19 +83,23 @@ private:
 	//	Utility
 	void checkMarkersFileNotSaved();
 	void changeMarkersFileUI(const bool state);
+	void enableMarkers(const bool enable);
 	void initializeIcons();
 	void showInfo();
 
 public slots:
 
 	void updateSlider();
-	void updateFrame(QPixmap p);
+	void updateFrame(const Frame &f);
 	void updateTime(qint64 time); //ms
 	void updateProgressText(QString m);
 	void changePlayPause(bool playState);
 	void endOfStream();
+	void seekFinished();
+	void indexChanged();
 
 	void jumpToFrame(const qint64 num);
+	void pinFrames(const QList<qint64> nums);
 	void changeStartEndBtn(const bool markerStarted);
 
 private slots:
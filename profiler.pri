@@ -0,0 +1,10 @@
+# ##############################################################################
+# Scoped timers of the hot paths (see Profiler.h): compiled in debug builds,
+# in release builds only when asked with: qmake CONFIG+=profiling
+# ##############################################################################
+CONFIG(debug, debug|release)|profiling {
+    DEFINES += PROFILING
+}
+
+SOURCES += $$PWD/Profiler.cpp
+HEADERS += $$PWD/Profiler.h